@@ -0,0 +1,119 @@
+/**
+ * @file LightBenchmark.cpp
+ * Measures light propagation throughput and the latency of incremental light
+ * updates, on the same terrain the demo generates. Needs no GL context.
+ * Usage: LightBenchmark [world size in chunks] [edit count]
+ * @author Matthew McLaurin
+ */
+
+#include "Chunk.h"
+#include "LightPropagator.h"
+#include "Terrain.h"
+#include "World.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+/** Gets the seconds elapsed since a time point. */
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Times full propagation of the world, repeated to smooth out noise.
+ * @param world World to light.
+ * @param repeats Number of passes.
+ */
+void benchmarkPropagateAll(World &world, int repeats)
+{
+    LightPropagator propagator;
+    propagator.propagateAll(world);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < repeats; i++)
+        propagator.propagateAll(world);
+    double seconds = secondsSince(start) / repeats;
+
+    double voxels = (double)world.chunks().size() * CHUNK_VOLUME;
+    std::cout << "propagateAll: " << seconds * 1000.0 << " ms per pass, "
+              << voxels / seconds / 1.0e6 << " million voxels/s" << std::endl;
+}
+
+/**
+ * Times single voxel updates, toggling random voxels the way the demo's
+ * scramble button does.
+ * @param world Lit world to edit.
+ * @param edits Number of voxels to toggle.
+ */
+void benchmarkVoxelChanged(World &world, int edits)
+{
+    LightPropagator propagator;
+    propagator.propagateAll(world);
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<size_t> chunkIndex(0, world.chunks().size() - 1);
+    std::uniform_int_distribution<int> local(0, CHUNK_SIZE - 1);
+    std::uniform_int_distribution<int> lamp(0, 15);
+
+    std::vector<double> latencies;
+    latencies.reserve(edits);
+    size_t affectedChunks = 0;
+    for (int i = 0; i < edits; i++) {
+        const ChunkPosition &p = world.chunks()[chunkIndex(random)].position();
+        int x = p.x * CHUNK_SIZE + local(random);
+        int y = p.y * CHUNK_SIZE + local(random);
+        int z = p.z * CHUNK_SIZE + local(random);
+
+        Voxel previous = world.voxel(x, y, z);
+        Voxel voxel = VOXEL_AIR;
+        if (previous == VOXEL_AIR)
+            voxel = lamp(random) == 0 ? VOXEL_LAMP : VOXEL_SOLID;
+
+        ChunkSet affected;
+        Clock::time_point start = Clock::now();
+        world.setVoxel(x, y, z, voxel);
+        propagator.voxelChanged(world, x, y, z, previous, affected);
+        latencies.push_back(secondsSince(start));
+        affectedChunks += affected.size();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0.0;
+    for (double latency : latencies)
+        total += latency;
+    auto percentile = [&latencies](double p) {
+        return latencies[(size_t)(p * (latencies.size() - 1))] * 1.0e6;
+    };
+
+    std::cout << "voxelChanged: " << edits << " edits, mean " << total / edits * 1.0e6
+              << " us, median " << percentile(0.5) << " us, p99 " << percentile(0.99)
+              << " us, max " << percentile(1.0) << " us, "
+              << (double)affectedChunks / edits << " chunks affected per edit" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 4;
+    int edits = argc > 2 ? atoi(argv[2]) : 10000;
+    if (size < 1 || edits < 1) {
+        std::cerr << "Usage: LightBenchmark [world size in chunks] [edit count]" << std::endl;
+        return 1;
+    }
+
+    // Same proportions as the demo world, which is 4 x 2 x 4 chunks.
+    World world(size, (size + 1) / 2, size);
+    generateTerrain(world);
+    std::cout << "World of " << world.chunks().size() << " chunks, "
+              << world.chunks().size() * CHUNK_VOLUME << " voxels" << std::endl;
+
+    benchmarkPropagateAll(world, 20);
+    benchmarkVoxelChanged(world, edits);
+    return 0;
+}
@@ -0,0 +1,6 @@
+# Compiler settings shared by the application, tests and benchmarks.
+
+# The headers in include/ use C++11.
+if (NOT MSVC)
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -std=c++11")
+endif()
@@ -0,0 +1,206 @@
+/**
+ * @file Chunk.h
+ * Fixed-size cubic block of voxels and their light levels, the unit of
+ * meshing and GPU upload.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/** Edge length of a chunk, in voxels. */
+const int CHUNK_SIZE = 16;
+/** Total number of voxels stored in one chunk. */
+const int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+/** Voxel type identifier. Zero is reserved for empty space. */
+typedef uint8_t Voxel;
+/** Voxel value representing empty space. */
+const Voxel VOXEL_AIR = 0;
+/** Plain opaque voxel. */
+const Voxel VOXEL_SOLID = 1;
+/** Opaque voxel which emits block light. */
+const Voxel VOXEL_LAMP = 2;
+
+/** Brightest possible light level, in either light channel. */
+const uint8_t MAX_LIGHT = 15;
+
+/**
+ * Gets the block light level emitted by a voxel type.
+ * @param voxel Voxel type.
+ * @return Emitted light level, zero for non-emissive voxels.
+ */
+inline uint8_t voxelEmission(Voxel voxel)
+{
+    return voxel == VOXEL_LAMP ? 14 : 0;
+}
+
+/** Light channels stored per voxel. */
+enum LightChannel
+{
+    /** Light coming down from the open sky. */
+    LIGHT_SKY,
+    /** Light emitted by voxels. */
+    LIGHT_BLOCK
+};
+
+/**
+ * @struct ChunkPosition
+ * Integer coordinates of a chunk within the world, measured in chunks.
+ */
+struct ChunkPosition
+{
+    int x;
+    int y;
+    int z;
+
+    bool operator==(const ChunkPosition &other) const
+    {
+        return x == other.x && y == other.y && z == other.z;
+    }
+
+    bool operator!=(const ChunkPosition &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @struct ChunkPositionHash
+ * Hash functor so that chunk positions can key unordered containers.
+ */
+struct ChunkPositionHash
+{
+    size_t operator()(const ChunkPosition &p) const
+    {
+        // Large primes spread neighbouring chunks across buckets. Unsigned
+        // arithmetic wraps instead of overflowing.
+        return (size_t)p.x * 73856093u ^ (size_t)p.y * 19349663u ^ (size_t)p.z * 83492791u;
+    }
+};
+
+/**
+ * @class Chunk
+ * Dense grid of CHUNK_SIZE^3 voxels, each with a sky and a block light level.
+ * Meshes are versioned by the World snapshots they are built from, not by
+ * the chunk.
+ */
+class Chunk
+{
+public:
+    /**
+     * Creates an empty chunk at the given world chunk coordinates.
+     * @param position Location of the chunk, measured in chunks.
+     */
+    Chunk(const ChunkPosition &position) : mPosition(position)
+    {
+        mVoxels.fill(VOXEL_AIR);
+        mLight.fill(0);
+    }
+
+    /**
+     * Gets a voxel by local coordinates. Coordinates outside of the chunk are
+     * treated as empty space.
+     * @param x Local x coordinate.
+     * @param y Local y coordinate.
+     * @param z Local z coordinate.
+     * @return Voxel at the location, or VOXEL_AIR if out of bounds.
+     */
+    Voxel get(int x, int y, int z) const
+    {
+        if (!contains(x, y, z))
+            return VOXEL_AIR;
+        return mVoxels[index(x, y, z)];
+    }
+
+    /**
+     * Sets a voxel by local coordinates. Out of bounds writes are ignored.
+     * @param x Local x coordinate.
+     * @param y Local y coordinate.
+     * @param z Local z coordinate.
+     * @param voxel New voxel value.
+     */
+    void set(int x, int y, int z, Voxel voxel)
+    {
+        if (!contains(x, y, z))
+            return;
+        mVoxels[index(x, y, z)] = voxel;
+    }
+
+    /**
+     * Gets a light level by local coordinates. Coordinates outside of the
+     * chunk are unlit.
+     * @param channel Light channel to read.
+     * @param x Local x coordinate.
+     * @param y Local y coordinate.
+     * @param z Local z coordinate.
+     * @return Light level in [0, MAX_LIGHT].
+     */
+    uint8_t light(LightChannel channel, int x, int y, int z) const
+    {
+        if (!contains(x, y, z))
+            return 0;
+        uint8_t packed = mLight[index(x, y, z)];
+        return channel == LIGHT_SKY ? packed >> 4 : packed & 0x0F;
+    }
+
+    /**
+     * Sets a light level by local coordinates. Out of bounds writes are
+     * ignored.
+     * @param channel Light channel to write.
+     * @param x Local x coordinate.
+     * @param y Local y coordinate.
+     * @param z Local z coordinate.
+     * @param level New light level in [0, MAX_LIGHT].
+     */
+    void setLight(LightChannel channel, int x, int y, int z, uint8_t level)
+    {
+        if (!contains(x, y, z))
+            return;
+        uint8_t &packed = mLight[index(x, y, z)];
+        if (channel == LIGHT_SKY)
+            packed = (uint8_t)((packed & 0x0F) | (level << 4));
+        else
+            packed = (uint8_t)((packed & 0xF0) | (level & 0x0F));
+    }
+
+    /** Resets both light channels of every voxel to zero. */
+    void clearLight()
+    {
+        mLight.fill(0);
+    }
+
+    /**
+     * Checks whether local coordinates lie inside of the chunk.
+     * @return True if all coordinates are in [0, CHUNK_SIZE).
+     */
+    static bool contains(int x, int y, int z)
+    {
+        return x >= 0 && x < CHUNK_SIZE &&
+               y >= 0 && y < CHUNK_SIZE &&
+               z >= 0 && z < CHUNK_SIZE;
+    }
+
+    /** Gets the location of the chunk, measured in chunks. */
+    const ChunkPosition &position() const
+    {
+        return mPosition;
+    }
+
+private:
+    /** Location of the chunk, measured in chunks. */
+    ChunkPosition mPosition;
+    /** Voxel storage, x-major within rows, then z, then y. */
+    std::array<Voxel, CHUNK_VOLUME> mVoxels;
+    /** Light storage, sky level in the high nibble and block in the low. */
+    std::array<uint8_t, CHUNK_VOLUME> mLight;
+
+    /** Converts local coordinates to a storage index. */
+    static int index(int x, int y, int z)
+    {
+        return x + CHUNK_SIZE * (z + CHUNK_SIZE * y);
+    }
+};
@@ -0,0 +1,235 @@
+/**
+ * @file ChunkMesh.h
+ * CPU-side chunk geometry and the face culling mesher that produces it.
+ * Meshes are built on worker threads and handed to the GL thread for upload.
+ * Lighting is baked during meshing: every vertex carries its ambient
+ * occlusion and the smoothed sky and block light levels around it.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include "Chunk.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Edge length of a chunk snapshot, which has a one voxel border. */
+const int SNAPSHOT_SIZE = CHUNK_SIZE + 2;
+
+/**
+ * @struct ChunkSnapshot
+ * Copy of a chunk's voxels and light plus a one voxel border taken from its
+ * neighbours. This is everything the mesher needs, so it can run on a worker
+ * thread while the world keeps changing.
+ */
+struct ChunkSnapshot
+{
+    /** Chunk the snapshot was taken from. */
+    ChunkPosition position;
+    /** Increases with every snapshot taken, so newer meshes win. */
+    uint32_t version;
+    /** Voxels, indexed by local coordinates offset by one. */
+    std::array<Voxel, SNAPSHOT_SIZE * SNAPSHOT_SIZE * SNAPSHOT_SIZE> voxels;
+    /** Light, sky level in the high nibble and block in the low. */
+    std::array<uint8_t, SNAPSHOT_SIZE * SNAPSHOT_SIZE * SNAPSHOT_SIZE> light;
+
+    /**
+     * Converts local chunk coordinates to a storage index.
+     * @return Index for coordinates in [-1, CHUNK_SIZE].
+     */
+    static int index(int x, int y, int z)
+    {
+        return (x + 1) + SNAPSHOT_SIZE * ((z + 1) + SNAPSHOT_SIZE * (y + 1));
+    }
+
+    /** Checks whether the voxel at local coordinates blocks light. */
+    bool opaque(int x, int y, int z) const
+    {
+        return voxels[index(x, y, z)] != VOXEL_AIR;
+    }
+};
+
+/**
+ * @struct ChunkVertex
+ * Interleaved vertex layout shared by the mesher and the GPU buffers.
+ * Positions are local to the owning chunk, whose origin is looked up on the
+ * GPU by chunk index.
+ */
+struct ChunkVertex
+{
+    float position[3];
+    float normal[3];
+    /** Index of the owning chunk. Assigned on upload, zero until then. */
+    uint32_t chunk;
+    /** Sky light, block light and ambient occlusion, scaled to [0, 255]. */
+    uint8_t light[4];
+};
+
+/**
+ * @struct ChunkMesh
+ * Triangle geometry for a single chunk, tagged with the version of the
+ * snapshot it was built from so that out of date meshes can be dropped.
+ */
+struct ChunkMesh
+{
+    /** Chunk this mesh belongs to. */
+    ChunkPosition position;
+    /** Version of the snapshot the mesh was built from. */
+    uint32_t version;
+    /** Interleaved vertex data. */
+    std::vector<ChunkVertex> vertices;
+    /** Counter-clockwise triangle indices into the vertex data. */
+    std::vector<uint32_t> indices;
+
+    /** Gets the number of bytes this mesh occupies once uploaded. */
+    size_t byteSize() const
+    {
+        return vertexBytes() + indexBytes();
+    }
+
+    /** Gets the size of the vertex data in bytes. */
+    size_t vertexBytes() const
+    {
+        return vertices.size() * sizeof(ChunkVertex);
+    }
+
+    /** Gets the size of the index data in bytes. */
+    size_t indexBytes() const
+    {
+        return indices.size() * sizeof(uint32_t);
+    }
+};
+
+/**
+ * Computes the baked lighting of one face vertex. The four cells in front of
+ * the face that touch the vertex decide both the ambient occlusion and the
+ * light level, which is averaged over whichever of those cells are open.
+ * @param snapshot Voxel and light data around the chunk.
+ * @param front Cell in front of the face.
+ * @param du Step from the front cell towards the vertex along one tangent.
+ * @param dv Step from the front cell towards the vertex along the other.
+ * @param out Receives sky, block and occlusion scaled to [0, 255].
+ */
+inline void bakeVertexLight(const ChunkSnapshot &snapshot, const int front[3],
+    const int du[3], const int dv[3], uint8_t out[4])
+{
+    int side1[3] = { front[0] + du[0], front[1] + du[1], front[2] + du[2] };
+    int side2[3] = { front[0] + dv[0], front[1] + dv[1], front[2] + dv[2] };
+    int corner[3] = { side1[0] + dv[0], side1[1] + dv[1], side1[2] + dv[2] };
+
+    bool s1 = snapshot.opaque(side1[0], side1[1], side1[2]);
+    bool s2 = snapshot.opaque(side2[0], side2[1], side2[2]);
+    bool c = snapshot.opaque(corner[0], corner[1], corner[2]);
+    // Two solid sides fully occlude the corner, whatever lies diagonally.
+    int ao = (s1 && s2) ? 0 : 3 - (int)s1 - (int)s2 - (int)c;
+
+    int sky = 0;
+    int block = 0;
+    int samples = 0;
+    const int *cells[4] = { front, side1, side2, corner };
+    bool open[4] = { true, !s1, !s2, !c && ao > 0 };
+    for (int i = 0; i < 4; i++) {
+        if (!open[i])
+            continue;
+        uint8_t packed = snapshot.light[ChunkSnapshot::index(cells[i][0], cells[i][1], cells[i][2])];
+        sky += packed >> 4;
+        block += packed & 0x0F;
+        samples++;
+    }
+
+    out[0] = (uint8_t)(sky * 17 / samples);
+    out[1] = (uint8_t)(block * 17 / samples);
+    out[2] = (uint8_t)(ao * 85);
+    out[3] = 0;
+}
+
+/**
+ * Builds a mesh containing every voxel face that borders empty space, with
+ * lighting baked into the vertices. Safe to call from any thread.
+ * @param snapshot Voxel and light data of the chunk and its border.
+ * @return Mesh of the visible faces of the chunk.
+ */
+inline ChunkMesh buildChunkMesh(const ChunkSnapshot &snapshot)
+{
+    // Normal, then four corners in counter-clockwise order seen from outside.
+    static const int faces[6][5][3] = {
+        { { 1, 0, 0 }, { 1, 0, 1 }, { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 } },
+        { { -1, 0, 0 }, { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 } },
+        { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+        { { 0, -1, 0 }, { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } },
+        { { 0, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } },
+        { { 0, 0, -1 }, { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } },
+    };
+
+    ChunkMesh mesh;
+    mesh.position = snapshot.position;
+    mesh.version = snapshot.version;
+
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                if (!snapshot.opaque(x, y, z))
+                    continue;
+
+                for (int f = 0; f < 6; f++) {
+                    const int *n = faces[f][0];
+                    int front[3] = { x + n[0], y + n[1], z + n[2] };
+                    // Skip faces hidden by a solid neighbour.
+                    if (snapshot.opaque(front[0], front[1], front[2]))
+                        continue;
+
+                    uint32_t base = (uint32_t)mesh.vertices.size();
+                    for (int c = 1; c < 5; c++) {
+                        const int *corner = faces[f][c];
+                        ChunkVertex v;
+                        int du[3] = { 0, 0, 0 };
+                        int dv[3] = { 0, 0, 0 };
+                        // Tangent steps point from the face centre towards the corner.
+                        int axis = 0;
+                        for (int a = 0; a < 3; a++) {
+                            if (n[a] != 0)
+                                continue;
+                            int *d = axis++ == 0 ? du : dv;
+                            d[a] = corner[a] == 1 ? 1 : -1;
+                        }
+
+                        v.position[0] = (float)(x + corner[0]);
+                        v.position[1] = (float)(y + corner[1]);
+                        v.position[2] = (float)(z + corner[2]);
+                        v.normal[0] = (float)n[0];
+                        v.normal[1] = (float)n[1];
+                        v.normal[2] = (float)n[2];
+                        v.chunk = 0;
+                        bakeVertexLight(snapshot, front, du, dv, v.light);
+                        mesh.vertices.push_back(v);
+                    }
+
+                    // Two triangles per quad. Split along the brighter
+                    // diagonal so occlusion interpolates without seams.
+                    const ChunkVertex *q = &mesh.vertices[base];
+                    if (q[0].light[2] + q[2].light[2] >= q[1].light[2] + q[3].light[2]) {
+                        mesh.indices.push_back(base + 0);
+                        mesh.indices.push_back(base + 1);
+                        mesh.indices.push_back(base + 2);
+                        mesh.indices.push_back(base + 0);
+                        mesh.indices.push_back(base + 2);
+                        mesh.indices.push_back(base + 3);
+                    }
+                    else {
+                        mesh.indices.push_back(base + 1);
+                        mesh.indices.push_back(base + 2);
+                        mesh.indices.push_back(base + 3);
+                        mesh.indices.push_back(base + 1);
+                        mesh.indices.push_back(base + 3);
+                        mesh.indices.push_back(base + 0);
+                    }
+                }
+            }
+        }
+    }
+
+    return mesh;
+}
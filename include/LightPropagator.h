@@ -0,0 +1,242 @@
+/**
+ * @file LightPropagator.h
+ * Flood fill voxel lighting. Sky light falls straight down from the top of
+ * the world without loss and spreads sideways losing one level per voxel;
+ * block light spreads from emissive voxels the same way in every direction.
+ * Results are stored in the chunks and baked into vertices by the mesher.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include "Chunk.h"
+#include "World.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Offsets to the six face neighbours of a voxel. */
+const int DIRECTIONS[6][3] = {
+    { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+};
+/** Index into DIRECTIONS of the downward neighbour. */
+const int DIRECTION_DOWN = 3;
+
+/**
+ * @class LightPropagator
+ * Computes light for a whole world, then keeps it up to date one voxel
+ * change at a time. Incremental updates use the usual two queue scheme:
+ * light that depended on the changed voxel is first removed breadth first,
+ * then whatever light bordered the removed region is spread back in. The
+ * queues are kept between calls to avoid reallocating them.
+ */
+class LightPropagator
+{
+public:
+    /**
+     * Discards all light in the world and recomputes it from scratch.
+     * @param world World to light.
+     */
+    void propagateAll(World &world)
+    {
+        for (Chunk &chunk : world.chunks())
+            chunk.clearLight();
+
+        // Seed sky light down every column until it hits something opaque.
+        int topChunk = world.top() / CHUNK_SIZE - 1;
+        for (const Chunk &chunk : world.chunks()) {
+            const ChunkPosition &p = chunk.position();
+            if (p.y != topChunk)
+                continue;
+            for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                    int x = p.x * CHUNK_SIZE + lx;
+                    int z = p.z * CHUNK_SIZE + lz;
+                    for (int y = world.top() - 1; y >= world.bottom(); y--) {
+                        if (world.voxel(x, y, z) != VOXEL_AIR)
+                            break;
+                        setLight(world, LIGHT_SKY, x, y, z, MAX_LIGHT, nullptr);
+                        mAdd.push_back({ x, y, z, MAX_LIGHT });
+                    }
+                }
+            }
+        }
+        spread(world, LIGHT_SKY, nullptr);
+
+        // Seed block light at every emissive voxel.
+        for (const Chunk &chunk : world.chunks()) {
+            const ChunkPosition &p = chunk.position();
+            for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+                for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                    for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                        uint8_t emission = voxelEmission(chunk.get(lx, ly, lz));
+                        if (emission == 0)
+                            continue;
+                        int x = p.x * CHUNK_SIZE + lx;
+                        int y = p.y * CHUNK_SIZE + ly;
+                        int z = p.z * CHUNK_SIZE + lz;
+                        setLight(world, LIGHT_BLOCK, x, y, z, emission, nullptr);
+                        mAdd.push_back({ x, y, z, emission });
+                    }
+                }
+            }
+        }
+        spread(world, LIGHT_BLOCK, nullptr);
+    }
+
+    /**
+     * Updates light after a single voxel has been changed in the world.
+     * @param world World containing the voxel, already holding the new value.
+     * @param x World x coordinate of the voxel.
+     * @param y World y coordinate of the voxel.
+     * @param z World z coordinate of the voxel.
+     * @param previous Voxel value before the change.
+     * @param affected Receives every chunk whose mesh needs rebuilding,
+     * including those affected by the geometry change itself.
+     */
+    void voxelChanged(World &world, int x, int y, int z, Voxel previous, ChunkSet &affected)
+    {
+        Voxel current = world.voxel(x, y, z);
+        bool opaque = current != VOXEL_AIR;
+        world.collectAffected(x, y, z, affected);
+
+        const LightChannel channels[2] = { LIGHT_SKY, LIGHT_BLOCK };
+        for (LightChannel channel : channels) {
+            uint8_t old = world.light(channel, x, y, z);
+            bool wasSource = channel == LIGHT_BLOCK && voxelEmission(previous) > 0;
+            uint8_t source = channel == LIGHT_BLOCK ? voxelEmission(current) : 0;
+
+            // Take out the light passing through, or emitted by, the voxel.
+            if (old > 0 && (opaque || wasSource)) {
+                setLight(world, channel, x, y, z, 0, &affected);
+                mRemove.push_back({ x, y, z, old });
+                unspread(world, channel, &affected);
+            }
+
+            if (source > 0) {
+                setLight(world, channel, x, y, z, source, &affected);
+                mAdd.push_back({ x, y, z, source });
+            }
+
+            // Nothing above the top layer can spread sky light back in, so
+            // an open voxel there is lit directly, as in propagateAll().
+            if (!opaque && channel == LIGHT_SKY && y == world.top() - 1) {
+                setLight(world, channel, x, y, z, MAX_LIGHT, &affected);
+                mAdd.push_back({ x, y, z, MAX_LIGHT });
+            }
+
+            // An open voxel lets light from its neighbours back in.
+            if (!opaque) {
+                for (int d = 0; d < 6; d++) {
+                    int nx = x + DIRECTIONS[d][0];
+                    int ny = y + DIRECTIONS[d][1];
+                    int nz = z + DIRECTIONS[d][2];
+                    uint8_t level = world.light(channel, nx, ny, nz);
+                    if (level > 0)
+                        mAdd.push_back({ nx, ny, nz, level });
+                }
+            }
+
+            spread(world, channel, &affected);
+        }
+    }
+
+private:
+    /** Voxel waiting in a propagation queue. */
+    struct LightNode
+    {
+        int x;
+        int y;
+        int z;
+        uint8_t level;
+    };
+
+    /** Voxels whose light should spread to their neighbours. */
+    std::vector<LightNode> mAdd;
+    /** Voxels whose former light should be removed from their neighbours. */
+    std::vector<LightNode> mRemove;
+
+    /**
+     * Gets the light a voxel passes on to a neighbour.
+     * @param channel Light channel.
+     * @param level Light level of the voxel.
+     * @param direction Index into DIRECTIONS of the neighbour.
+     */
+    static uint8_t falloff(LightChannel channel, uint8_t level, int direction)
+    {
+        if (channel == LIGHT_SKY && direction == DIRECTION_DOWN && level == MAX_LIGHT)
+            return MAX_LIGHT;
+        return level > 0 ? level - 1 : 0;
+    }
+
+    /** Writes a light level, recording the chunks that need remeshing. */
+    static void setLight(World &world, LightChannel channel, int x, int y, int z,
+        uint8_t level, ChunkSet *affected)
+    {
+        world.setLight(channel, x, y, z, level);
+        if (affected)
+            world.collectAffected(x, y, z, *affected);
+    }
+
+    /** Spreads light breadth first from every voxel in the add queue. */
+    void spread(World &world, LightChannel channel, ChunkSet *affected)
+    {
+        for (size_t head = 0; head < mAdd.size(); head++) {
+            LightNode node = mAdd[head];
+            // The stored level may have changed since the node was queued.
+            uint8_t level = world.light(channel, node.x, node.y, node.z);
+
+            for (int d = 0; d < 6; d++) {
+                uint8_t next = falloff(channel, level, d);
+                if (next == 0)
+                    continue;
+                int nx = node.x + DIRECTIONS[d][0];
+                int ny = node.y + DIRECTIONS[d][1];
+                int nz = node.z + DIRECTIONS[d][2];
+                if (!world.contains(nx, ny, nz) || world.voxel(nx, ny, nz) != VOXEL_AIR)
+                    continue;
+                if (world.light(channel, nx, ny, nz) >= next)
+                    continue;
+
+                setLight(world, channel, nx, ny, nz, next, affected);
+                mAdd.push_back({ nx, ny, nz, next });
+            }
+        }
+        mAdd.clear();
+    }
+
+    /**
+     * Removes light that originated from the voxels in the remove queue.
+     * Neighbours lit from elsewhere are queued in the add queue instead, so
+     * a following spread() refills the darkened region.
+     */
+    void unspread(World &world, LightChannel channel, ChunkSet *affected)
+    {
+        for (size_t head = 0; head < mRemove.size(); head++) {
+            LightNode node = mRemove[head];
+
+            for (int d = 0; d < 6; d++) {
+                int nx = node.x + DIRECTIONS[d][0];
+                int ny = node.y + DIRECTIONS[d][1];
+                int nz = node.z + DIRECTIONS[d][2];
+                uint8_t level = world.light(channel, nx, ny, nz);
+                if (level == 0)
+                    continue;
+
+                // A neighbour is dependent if it could have been lit by this
+                // voxel. Emitters always keep their own light.
+                bool dependent = level < node.level ||
+                    (level == MAX_LIGHT && falloff(channel, node.level, d) == MAX_LIGHT);
+                if (dependent && voxelEmission(world.voxel(nx, ny, nz)) == 0) {
+                    setLight(world, channel, nx, ny, nz, 0, affected);
+                    mRemove.push_back({ nx, ny, nz, level });
+                }
+                else {
+                    mAdd.push_back({ nx, ny, nz, level });
+                }
+            }
+        }
+        mRemove.clear();
+    }
+};
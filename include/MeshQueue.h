@@ -0,0 +1,95 @@
+/**
+ * @file MeshQueue.h
+ * Lock-free multiple producer, single consumer queue used to hand finished
+ * meshes from worker threads to the GL thread.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @class MeshQueue
+ * Intrusive linked list queue after Dmitry Vyukov's MPSC design. Producers
+ * never block: a push is one allocation plus one atomic exchange. The single
+ * consumer never blocks either, but may briefly see the queue as empty while
+ * a producer is between its exchange and its link store.
+ * @tparam T Element type. Must be default and move constructible.
+ */
+template <typename T>
+class MeshQueue
+{
+public:
+    MeshQueue() : mHead(&mStub), mTail(&mStub)
+    {
+    }
+
+    MeshQueue(const MeshQueue &) = delete;
+    MeshQueue &operator=(const MeshQueue &) = delete;
+
+    /**
+     * Destructor frees any elements that were never consumed. No producer may
+     * be pushing while the queue is destroyed.
+     */
+    ~MeshQueue()
+    {
+        T discard;
+        while (tryPop(discard)) {
+        }
+        if (mTail != &mStub)
+            delete mTail;
+    }
+
+    /**
+     * Adds an element to the back of the queue. Safe to call from any number
+     * of threads concurrently.
+     * @param value Element to add.
+     */
+    void push(T value)
+    {
+        Node *node = new Node(std::move(value));
+        Node *previous = mHead.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * Removes the element at the front of the queue. Must only be called from
+     * the consumer thread.
+     * @param out Receives the element if one was available.
+     * @return True if an element was removed, false if the queue was empty.
+     */
+    bool tryPop(T &out)
+    {
+        Node *tail = mTail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return false;
+
+        // The popped node becomes the new sentinel, so only its value leaves.
+        out = std::move(next->value);
+        mTail = next;
+        if (tail != &mStub)
+            delete tail;
+        return true;
+    }
+
+private:
+    /** Singly linked queue node. */
+    struct Node
+    {
+        Node() : next(nullptr) {}
+        explicit Node(T &&v) : next(nullptr), value(std::move(v)) {}
+
+        std::atomic<Node *> next;
+        T value;
+    };
+
+    /** Initial sentinel node, owned by the queue itself. */
+    Node mStub;
+    /** Most recently pushed node. Shared by all producers. */
+    std::atomic<Node *> mHead;
+    /** Current sentinel node. Only touched by the consumer. */
+    Node *mTail;
+};
@@ -0,0 +1,436 @@
+/**
+ * @file MeshUploader.h
+ * GPU residency of chunk meshes. All chunks share one vertex buffer and one
+ * index buffer, carved up by RangeAllocator, so every resident chunk can be
+ * drawn with a single multi-draw call. Each chunk is double-buffered so the
+ * old mesh keeps drawing until the new one has finished uploading, and the
+ * old mesh's ranges are only reused once the GPU has finished drawing it.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include "ChunkMesh.h"
+#include "RangeAllocator.h"
+
+#include <nanogui/opengl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+/** Initial vertex capacity of the shared vertex buffer. */
+const size_t INITIAL_VERTEX_CAPACITY = 256 * 1024;
+/** Initial index capacity of the shared index buffer. */
+const size_t INITIAL_INDEX_CAPACITY = 512 * 1024;
+
+/**
+ * @class MeshUploader
+ * Owns the shared mesh buffers and tracks where each chunk's mesh lives in
+ * them. Every chunk has a front mesh, which is drawn, and optionally a back
+ * mesh, which is being uploaded. A fence placed after the upload decides when
+ * the back mesh is swapped to the front. A replaced front mesh may still be
+ * read by draws in flight, so its ranges are retired behind a fence placed
+ * after the next draw rather than freed at once. Chunk origins live in a buffer
+ * texture indexed by the chunk number stored in each vertex. Must only be
+ * used on the GL thread.
+ */
+class MeshUploader
+{
+public:
+    MeshUploader() : mVertexRanges(INITIAL_VERTEX_CAPACITY), mIndexRanges(INITIAL_INDEX_CAPACITY)
+    {
+    }
+
+    /**
+     * Copies a mesh into the shared buffers and makes it the chunk's back
+     * mesh. Any earlier back mesh that has not yet become resident is
+     * discarded, and meshes older than the chunk's last upload are ignored.
+     * Leaves the bound vertex array untouched.
+     * @param mesh Mesh to upload.
+     */
+    void upload(const ChunkMesh &mesh)
+    {
+        if (mVertexBuffer == 0)
+            createBuffers();
+
+        auto found = mSlots.find(mesh.position);
+        if (found == mSlots.end())
+            found = mSlots.emplace(mesh.position, createSlot(mesh.position)).first;
+
+        ChunkSlot &slot = found->second;
+        if (mesh.version < slot.version)
+            return;
+        slot.version = mesh.version;
+        // A back mesh is never drawn, so its ranges can be reused at once.
+        if (slot.hasBack)
+            release(slot.back);
+
+        ChunkDraw draw;
+        if (!mesh.indices.empty()) {
+            draw.vertexOffset = allocate(mVertexRanges, mVertexBuffer,
+                sizeof(ChunkVertex), mesh.vertices.size(), true);
+            draw.indexOffset = allocate(mIndexRanges, mIndexBuffer,
+                sizeof(uint32_t), mesh.indices.size(), false);
+            draw.indexCount = (GLsizei)mesh.indices.size();
+
+            // Tag each vertex with the chunk's row in the origin table.
+            mStaging.assign(mesh.vertices.begin(), mesh.vertices.end());
+            for (ChunkVertex &v : mStaging)
+                v.chunk = slot.index;
+
+            // Uploads go through the copy target: binding the element array
+            // target would change whichever vertex array is bound.
+            glBindBuffer(GL_COPY_WRITE_BUFFER, mVertexBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, draw.vertexOffset * sizeof(ChunkVertex),
+                mesh.vertexBytes(), mStaging.data());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, mIndexBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, draw.indexOffset * sizeof(uint32_t),
+                mesh.indexBytes(), mesh.indices.data());
+        }
+        // Empty meshes are fenced too, so clearing a chunk orders correctly.
+        draw.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        slot.back = draw;
+        slot.hasBack = true;
+    }
+
+    /**
+     * Swaps in every back mesh whose upload has completed, retiring the mesh
+     * it replaces. Also frees retired ranges no longer read by any draw.
+     * Never waits on the GPU.
+     */
+    void promote()
+    {
+        reclaim();
+
+        for (auto &entry : mSlots) {
+            ChunkSlot &slot = entry.second;
+            if (!slot.hasBack)
+                continue;
+
+            GLenum status = glClientWaitSync(slot.back.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                continue;
+
+            glDeleteSync(slot.back.fence);
+            slot.back.fence = nullptr;
+            retire(slot.front);
+            slot.front = slot.back;
+            slot.back = ChunkDraw();
+            slot.hasBack = false;
+        }
+    }
+
+    /**
+     * Draws every resident chunk with one glMultiDrawElementsBaseVertex call.
+     * The GL calls issued do not depend on the number of chunks. Expects the
+     * shader's vertex array to be bound, and binds the index buffer to it.
+     * Fences the ranges retired since the last draw.
+     * @param positionAttrib Location of the vec3 position attribute.
+     * @param normalAttrib Location of the vec3 normal attribute.
+     * @param chunkAttrib Location of the uint chunk index attribute.
+     * @param lightAttrib Location of the vec4 baked light attribute.
+     * @param originUnit Texture unit to bind the chunk origin table to.
+     */
+    void draw(GLint positionAttrib, GLint normalAttrib, GLint chunkAttrib, GLint lightAttrib,
+        GLuint originUnit)
+    {
+        mCounts.clear();
+        mIndexOffsets.clear();
+        mBaseVertices.clear();
+        for (const auto &entry : mSlots) {
+            const ChunkDraw &front = entry.second.front;
+            if (front.indexCount == 0)
+                continue;
+            mCounts.push_back(front.indexCount);
+            mIndexOffsets.push_back((const void *)(front.indexOffset * sizeof(uint32_t)));
+            mBaseVertices.push_back((GLint)front.vertexOffset);
+        }
+        if (mCounts.empty()) {
+            fenceRetired();
+            return;
+        }
+
+        glActiveTexture(GL_TEXTURE0 + originUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, mOriginTexture);
+        if (mOriginsDirty) {
+            glBindBuffer(GL_TEXTURE_BUFFER, mOriginBuffer);
+            glBufferData(GL_TEXTURE_BUFFER, mOrigins.size() * sizeof(float), mOrigins.data(), GL_STATIC_DRAW);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mOriginBuffer);
+            mOriginsDirty = false;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+        glEnableVertexAttribArray(positionAttrib);
+        glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex),
+            (const void *)offsetof(ChunkVertex, position));
+        glEnableVertexAttribArray(normalAttrib);
+        glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex),
+            (const void *)offsetof(ChunkVertex, normal));
+        glEnableVertexAttribArray(chunkAttrib);
+        glVertexAttribIPointer(chunkAttrib, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex),
+            (const void *)offsetof(ChunkVertex, chunk));
+        glEnableVertexAttribArray(lightAttrib);
+        glVertexAttribPointer(lightAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ChunkVertex),
+            (const void *)offsetof(ChunkVertex, light));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, mCounts.data(), GL_UNSIGNED_INT,
+            mIndexOffsets.data(), (GLsizei)mCounts.size(), mBaseVertices.data());
+        fenceRetired();
+    }
+
+    /** Gets the total GPU storage allocated for mesh data, in bytes. */
+    size_t allocatedBytes() const
+    {
+        return mVertexRanges.capacity() * sizeof(ChunkVertex) +
+               mIndexRanges.capacity() * sizeof(uint32_t);
+    }
+
+    /** Releases all buffers and fences. */
+    void free()
+    {
+        for (auto &entry : mSlots) {
+            release(entry.second.front);
+            release(entry.second.back);
+        }
+        mSlots.clear();
+        for (ChunkDraw &draw : mRetiring)
+            release(draw);
+        mRetiring.clear();
+        for (RetiredBatch &batch : mRetired) {
+            for (ChunkDraw &draw : batch.draws)
+                release(draw);
+            glDeleteSync(batch.fence);
+        }
+        mRetired.clear();
+
+        glDeleteBuffers(1, &mVertexBuffer);
+        glDeleteBuffers(1, &mIndexBuffer);
+        glDeleteBuffers(1, &mOriginBuffer);
+        glDeleteTextures(1, &mOriginTexture);
+        mVertexBuffer = mIndexBuffer = mOriginBuffer = mOriginTexture = 0;
+    }
+
+private:
+    /** Location of one chunk mesh in the shared buffers. */
+    struct ChunkDraw
+    {
+        size_t vertexOffset = 0;
+        size_t indexOffset = 0;
+        /** Zero when the mesh is empty and owns no ranges. */
+        GLsizei indexCount = 0;
+        GLsync fence = nullptr;
+    };
+
+    /** Front and back mesh of one chunk. */
+    struct ChunkSlot
+    {
+        ChunkDraw front;
+        ChunkDraw back;
+        bool hasBack = false;
+        uint32_t version = 0;
+        /** Row of the chunk in the origin table. */
+        uint32_t index = 0;
+    };
+
+    /** Replaced meshes waiting for the draws before a fence to finish. */
+    struct RetiredBatch
+    {
+        GLsync fence;
+        std::vector<ChunkDraw> draws;
+    };
+
+    /** Shared vertex storage, in units of ChunkVertex. */
+    RangeAllocator mVertexRanges;
+    /** Shared index storage, in units of uint32_t. */
+    RangeAllocator mIndexRanges;
+    GLuint mVertexBuffer = 0;
+    GLuint mIndexBuffer = 0;
+    /** Buffer texture holding one vec4 origin per chunk. */
+    GLuint mOriginBuffer = 0;
+    GLuint mOriginTexture = 0;
+    /** CPU copy of the origin table. */
+    std::vector<float> mOrigins;
+    /** Set when the origin table must be re-sent to the GPU. */
+    bool mOriginsDirty = false;
+    /** Per-chunk residency. */
+    std::unordered_map<ChunkPosition, ChunkSlot, ChunkPositionHash> mSlots;
+    /** Meshes retired since the last draw, not yet fenced. */
+    std::vector<ChunkDraw> mRetiring;
+    /** Fenced retired meshes, oldest fence first. */
+    std::deque<RetiredBatch> mRetired;
+    /** Scratch copy of vertex data being tagged for upload. */
+    std::vector<ChunkVertex> mStaging;
+    /** Multi-draw arguments, kept to avoid per-frame allocation. */
+    std::vector<GLsizei> mCounts;
+    std::vector<const void *> mIndexOffsets;
+    std::vector<GLint> mBaseVertices;
+
+    /** Allocates storage for the shared buffers at their initial capacity. */
+    void createBuffers()
+    {
+        glGenBuffers(1, &mVertexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mVertexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, mVertexRanges.capacity() * sizeof(ChunkVertex), nullptr, GL_DYNAMIC_DRAW);
+        glGenBuffers(1, &mIndexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mIndexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, mIndexRanges.capacity() * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+        glGenBuffers(1, &mOriginBuffer);
+        glGenTextures(1, &mOriginTexture);
+    }
+
+    /** Creates a chunk slot and appends the chunk's origin to the table. */
+    ChunkSlot createSlot(const ChunkPosition &p)
+    {
+        ChunkSlot slot;
+        slot.index = (uint32_t)(mOrigins.size() / 4);
+        mOrigins.push_back((float)(p.x * CHUNK_SIZE));
+        mOrigins.push_back((float)(p.y * CHUNK_SIZE));
+        mOrigins.push_back((float)(p.z * CHUNK_SIZE));
+        mOrigins.push_back(0.0f);
+        mOriginsDirty = true;
+        return slot;
+    }
+
+    /**
+     * Allocates a range of a shared buffer. If the free space is too
+     * fragmented the buffer is compacted, and if it is too small the buffer
+     * doubles in size. Either way the contents move to a new buffer object
+     * and every chunk's offsets are updated.
+     * @param ranges Allocator of the buffer.
+     * @param buffer Buffer object, replaced if the buffer is rebuilt.
+     * @param unitSize Size of one unit in bytes.
+     * @param size Number of units required.
+     * @param vertices True for the vertex buffer, false for the index buffer.
+     * @return Offset of the range, in units.
+     */
+    size_t allocate(RangeAllocator &ranges, GLuint &buffer, size_t unitSize, size_t size,
+        bool vertices)
+    {
+        size_t offset = 0;
+        if (ranges.allocate(size, offset))
+            return offset;
+
+        size_t oldCapacity = ranges.capacity();
+        std::vector<RangeAllocator::Move> moves = ranges.compact();
+        if (ranges.freeSize() < size) {
+            size_t needed = ranges.usedSize() + size;
+            ranges.grow(oldCapacity * 2 > needed ? oldCapacity * 2 : needed);
+        }
+
+        // Copy everything across, then re-copy moved ranges from the old
+        // buffer so that overlapping moves never read overwritten data.
+        GLuint rebuilt = 0;
+        glGenBuffers(1, &rebuilt);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, rebuilt);
+        glBufferData(GL_COPY_WRITE_BUFFER, ranges.capacity() * unitSize, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldCapacity * unitSize);
+        for (const RangeAllocator::Move &move : moves) {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                move.from * unitSize, move.to * unitSize, move.size * unitSize);
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = rebuilt;
+
+        if (!moves.empty())
+            relocate(moves, vertices);
+
+        ranges.allocate(size, offset);
+        return offset;
+    }
+
+    /**
+     * Applies compaction moves to the offsets stored in each chunk slot.
+     * @param moves Moves reported by RangeAllocator::compact().
+     * @param vertices True if the moves apply to vertex offsets.
+     */
+    void relocate(const std::vector<RangeAllocator::Move> &moves, bool vertices)
+    {
+        std::unordered_map<size_t, size_t> moved;
+        for (const RangeAllocator::Move &move : moves)
+            moved[move.from] = move.to;
+
+        auto apply = [&](ChunkDraw &draw) {
+            if (draw.indexCount == 0)
+                return;
+            size_t &offset = vertices ? draw.vertexOffset : draw.indexOffset;
+            auto it = moved.find(offset);
+            if (it != moved.end())
+                offset = it->second;
+        };
+        for (auto &entry : mSlots) {
+            apply(entry.second.front);
+            apply(entry.second.back);
+        }
+        // Retired ranges are still allocated, so they move as well.
+        for (ChunkDraw &draw : mRetiring)
+            apply(draw);
+        for (RetiredBatch &batch : mRetired) {
+            for (ChunkDraw &draw : batch.draws)
+                apply(draw);
+        }
+    }
+
+    /**
+     * Takes a replaced front mesh out of use. Its ranges stay allocated
+     * until a fence placed after a later draw has signalled.
+     */
+    void retire(ChunkDraw &draw)
+    {
+        if (draw.fence != nullptr)
+            glDeleteSync(draw.fence);
+        if (draw.indexCount > 0) {
+            draw.fence = nullptr;
+            mRetiring.push_back(draw);
+        }
+        draw = ChunkDraw();
+    }
+
+    /**
+     * Places a fence after the draws issued so far, guarding every mesh
+     * retired since the previous fence. Earlier draws are the only ones that
+     * can read those meshes, so the fence covers them all.
+     */
+    void fenceRetired()
+    {
+        if (mRetiring.empty())
+            return;
+        mRetired.push_back(RetiredBatch());
+        mRetired.back().fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mRetired.back().draws.swap(mRetiring);
+    }
+
+    /** Frees retired meshes whose fence has signalled. Never waits. */
+    void reclaim()
+    {
+        while (!mRetired.empty()) {
+            RetiredBatch &batch = mRetired.front();
+            GLenum status = glClientWaitSync(batch.fence, 0, 0);
+            // Fences signal in order, so later batches are still busy too.
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                return;
+
+            glDeleteSync(batch.fence);
+            for (ChunkDraw &draw : batch.draws)
+                release(draw);
+            mRetired.pop_front();
+        }
+    }
+
+    /** Returns a mesh's ranges to the allocators and deletes its fence. */
+    void release(ChunkDraw &draw)
+    {
+        if (draw.indexCount > 0) {
+            mVertexRanges.release(draw.vertexOffset);
+            mIndexRanges.release(draw.indexOffset);
+        }
+        if (draw.fence != nullptr)
+            glDeleteSync(draw.fence);
+        draw = ChunkDraw();
+    }
+};
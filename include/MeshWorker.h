@@ -0,0 +1,108 @@
+/**
+ * @file MeshWorker.h
+ * Background threads that turn chunk snapshots into meshes and publish them
+ * to a MeshQueue for the GL thread.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include "ChunkMesh.h"
+#include "MeshQueue.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Queue type carrying finished meshes to the GL thread. */
+typedef MeshQueue<std::unique_ptr<ChunkMesh>> ChunkMeshQueue;
+
+/**
+ * @class MeshWorker
+ * Pool of meshing threads. Jobs are snapshots of chunk data, so the caller
+ * may keep editing its chunks while meshing is in flight; the version stored
+ * in each mesh tells stale results apart.
+ */
+class MeshWorker
+{
+public:
+    /**
+     * Starts the worker threads.
+     * @param output Queue receiving finished meshes. Must outlive the worker.
+     * @param threadCount Number of threads, or zero to pick from hardware.
+     */
+    MeshWorker(ChunkMeshQueue &output, unsigned threadCount = 0)
+        : mOutput(output), mStopping(false)
+    {
+        if (threadCount == 0) {
+            unsigned cores = std::thread::hardware_concurrency();
+            // Leave a core for the GL thread.
+            threadCount = cores > 1 ? cores - 1 : 1;
+        }
+        for (unsigned i = 0; i < threadCount; i++)
+            mThreads.emplace_back(&MeshWorker::run, this);
+    }
+
+    MeshWorker(const MeshWorker &) = delete;
+    MeshWorker &operator=(const MeshWorker &) = delete;
+
+    /** Destructor drops unstarted jobs and joins all threads. */
+    ~MeshWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+            mJobs.clear();
+        }
+        mCondition.notify_all();
+        for (std::thread &thread : mThreads)
+            thread.join();
+    }
+
+    /**
+     * Queues a chunk snapshot for meshing.
+     * @param snapshot Chunk data to mesh. Copied into the job list.
+     */
+    void submit(const ChunkSnapshot &snapshot)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobs.push_back(snapshot);
+        }
+        mCondition.notify_one();
+    }
+
+private:
+    /** Destination of finished meshes. */
+    ChunkMeshQueue &mOutput;
+    /** Snapshots waiting to be meshed. */
+    std::deque<ChunkSnapshot> mJobs;
+    /** Guards the job list and stop flag. */
+    std::mutex mMutex;
+    /** Signals new jobs or shutdown. */
+    std::condition_variable mCondition;
+    /** Set when the worker is being destroyed. */
+    bool mStopping;
+    /** Meshing threads. */
+    std::vector<std::thread> mThreads;
+
+    /** Thread body. Meshes jobs until asked to stop. */
+    void run()
+    {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+            if (mStopping)
+                return;
+
+            ChunkSnapshot snapshot = mJobs.front();
+            mJobs.pop_front();
+            lock.unlock();
+
+            mOutput.push(std::unique_ptr<ChunkMesh>(new ChunkMesh(buildChunkMesh(snapshot))));
+        }
+    }
+};
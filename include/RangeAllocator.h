@@ -0,0 +1,211 @@
+/**
+ * @file RangeAllocator.h
+ * Sub-allocator handing out ranges of a large linear buffer. Works in abstract
+ * units (vertices, indices) and makes no GL calls; the owner of the actual
+ * buffer applies the moves it reports when compacting.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <vector>
+
+/**
+ * @class RangeAllocator
+ * Best-fit allocator over [0, capacity). Free ranges are coalesced with their
+ * neighbours on release. When fragmentation prevents an allocation, compact()
+ * slides every allocation towards the start, leaving one free range at the
+ * end, and grow() appends space to that range.
+ */
+class RangeAllocator
+{
+public:
+    /** Relocation of one allocation, reported by compact(). */
+    struct Move
+    {
+        size_t from;
+        size_t to;
+        size_t size;
+    };
+
+    /**
+     * Creates an allocator with the whole capacity free.
+     * @param capacity Number of units available.
+     */
+    explicit RangeAllocator(size_t capacity = 0) : mCapacity(0), mUsedSize(0)
+    {
+        grow(capacity);
+    }
+
+    /**
+     * Allocates a range using the smallest free range that fits.
+     * @param size Number of units required. Must be greater than zero.
+     * @param offset Receives the start of the range on success.
+     * @return True on success, false if no free range is large enough.
+     */
+    bool allocate(size_t size, size_t &offset)
+    {
+        auto best = mFree.end();
+        for (auto it = mFree.begin(); it != mFree.end(); ++it) {
+            if (it->second >= size && (best == mFree.end() || it->second < best->second)) {
+                best = it;
+                if (best->second == size)
+                    break;
+            }
+        }
+        if (best == mFree.end())
+            return false;
+
+        offset = best->first;
+        size_t remaining = best->second - size;
+        mFree.erase(best);
+        if (remaining > 0)
+            mFree[offset + size] = remaining;
+
+        mUsed[offset] = size;
+        mUsedSize += size;
+        return true;
+    }
+
+    /**
+     * Releases a range returned by allocate(). Unknown offsets are ignored.
+     * @param offset Start of the range.
+     */
+    void release(size_t offset)
+    {
+        auto used = mUsed.find(offset);
+        if (used == mUsed.end())
+            return;
+        size_t size = used->second;
+        mUsed.erase(used);
+        mUsedSize -= size;
+
+        // Merge with the following free range.
+        auto next = mFree.find(offset + size);
+        if (next != mFree.end()) {
+            size += next->second;
+            mFree.erase(next);
+        }
+
+        // Merge with the preceding free range.
+        auto it = mFree.lower_bound(offset);
+        if (it != mFree.begin()) {
+            auto previous = std::prev(it);
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                return;
+            }
+        }
+        mFree[offset] = size;
+    }
+
+    /**
+     * Moves every allocation down so all free space forms a single range at
+     * the end. Allocations keep their relative order.
+     * @return Moves to apply to the backing buffer, in ascending order. Each
+     * move's source and destination may overlap.
+     */
+    std::vector<Move> compact()
+    {
+        std::vector<Move> moves;
+        std::map<size_t, size_t> used;
+        size_t cursor = 0;
+
+        for (const auto &entry : mUsed) {
+            if (entry.first != cursor)
+                moves.push_back({ entry.first, cursor, entry.second });
+            used[cursor] = entry.second;
+            cursor += entry.second;
+        }
+
+        mUsed.swap(used);
+        mFree.clear();
+        if (cursor < mCapacity)
+            mFree[cursor] = mCapacity - cursor;
+        return moves;
+    }
+
+    /**
+     * Extends the capacity. Smaller capacities are ignored.
+     * @param capacity New number of units available.
+     */
+    void grow(size_t capacity)
+    {
+        if (capacity <= mCapacity)
+            return;
+
+        size_t added = capacity - mCapacity;
+        size_t start = mCapacity;
+        mCapacity = capacity;
+
+        // Extend a free range that already reaches the old end.
+        if (!mFree.empty()) {
+            auto last = std::prev(mFree.end());
+            if (last->first + last->second == start) {
+                last->second += added;
+                return;
+            }
+        }
+        mFree[start] = added;
+    }
+
+    /** Gets the total number of units managed. */
+    size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    /** Gets the number of allocated units. */
+    size_t usedSize() const
+    {
+        return mUsedSize;
+    }
+
+    /** Gets the number of free units. */
+    size_t freeSize() const
+    {
+        return mCapacity - mUsedSize;
+    }
+
+    /** Gets the size of the largest free range. */
+    size_t largestFreeRange() const
+    {
+        size_t largest = 0;
+        for (const auto &entry : mFree) {
+            if (entry.second > largest)
+                largest = entry.second;
+        }
+        return largest;
+    }
+
+    /**
+     * Gets how fragmented the free space is, from 0 when it is one range to
+     * nearly 1 when it is scattered in many small pieces.
+     */
+    float fragmentation() const
+    {
+        size_t free = freeSize();
+        if (free == 0)
+            return 0.0f;
+        return 1.0f - (float)largestFreeRange() / (float)free;
+    }
+
+    /** Gets the number of live allocations. */
+    size_t allocationCount() const
+    {
+        return mUsed.size();
+    }
+
+private:
+    /** Total number of units managed. */
+    size_t mCapacity;
+    /** Number of allocated units. */
+    size_t mUsedSize;
+    /** Free ranges, offset to size. Never adjacent to each other. */
+    std::map<size_t, size_t> mFree;
+    /** Live allocations, offset to size. */
+    std::map<size_t, size_t> mUsed;
+};
@@ -0,0 +1,43 @@
+/**
+ * @file Terrain.h
+ * Procedural terrain used to fill the demo world. Shared with the light
+ * benchmark so that both work on the same voxels.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include "Chunk.h"
+#include "World.h"
+
+#include <cmath>
+
+/**
+ * Fills the chunks with rolling hills sampled from a height function, with a
+ * lamp on the surface in the middle of each chunk column. Does not light the
+ * world.
+ * @param world World to fill. Expected to be empty.
+ */
+inline void generateTerrain(World &world)
+{
+    for (Chunk &chunk : world.chunks()) {
+        const ChunkPosition &p = chunk.position();
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                float wx = (float)(p.x * CHUNK_SIZE + x);
+                float wz = (float)(p.z * CHUNK_SIZE + z);
+                float height = 6.0f * sinf(wx * 0.15f) * cosf(wz * 0.2f);
+
+                for (int y = 0; y < CHUNK_SIZE; y++) {
+                    if (p.y * CHUNK_SIZE + y < height)
+                        chunk.set(x, y, z, VOXEL_SOLID);
+                }
+
+                // Put a lamp on the surface in the middle of each column.
+                int surface = (int)ceilf(height) - p.y * CHUNK_SIZE;
+                if (x == CHUNK_SIZE / 2 && z == CHUNK_SIZE / 2 && Chunk::contains(x, surface, z))
+                    chunk.set(x, surface, z, VOXEL_LAMP);
+            }
+        }
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * @file UploadScheduler.h
+ * Frame budgeted ordering of pending chunk mesh uploads. Contains no GL calls,
+ * the actual upload and the clock are supplied by the caller.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include "ChunkMesh.h"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * @struct UploadBudget
+ * Limits on how much mesh data may be uploaded in a single frame.
+ */
+struct UploadBudget
+{
+    /** Maximum number of bytes uploaded per frame. */
+    size_t maxBytes = 4 * 1024 * 1024;
+    /** Maximum time spent uploading per frame, in seconds. */
+    double maxSeconds = 0.002;
+};
+
+/**
+ * @class UploadScheduler
+ * Holds meshes waiting for upload and releases them a frame's budget at a
+ * time. If a chunk is remeshed again before its previous mesh was uploaded,
+ * the older mesh is dropped, so a burst of remeshes costs one upload per chunk
+ * and never more than one frame's budget at once.
+ */
+class UploadScheduler
+{
+public:
+    /**
+     * Sets the per-frame budget. Takes effect on the next call to process().
+     * @param budget New limits.
+     */
+    void setBudget(const UploadBudget &budget)
+    {
+        mBudget = budget;
+    }
+
+    /** Gets the current per-frame budget. */
+    const UploadBudget &budget() const
+    {
+        return mBudget;
+    }
+
+    /**
+     * Queues a mesh for upload. Replaces any pending mesh of the same chunk
+     * unless the pending mesh was built from newer data.
+     * @param mesh Mesh to queue. Ignored if null.
+     */
+    void enqueue(std::unique_ptr<ChunkMesh> mesh)
+    {
+        if (!mesh)
+            return;
+
+        auto it = mPending.find(mesh->position);
+        if (it == mPending.end()) {
+            mOrder.push_back(mesh->position);
+            mPending.emplace(mesh->position, std::move(mesh));
+        }
+        else if (it->second->version <= mesh->version) {
+            // Keep the original queue position so the chunk isn't starved.
+            it->second = std::move(mesh);
+        }
+    }
+
+    /**
+     * Uploads pending meshes in arrival order until the frame budget runs out.
+     * The first mesh of a frame is always uploaded, so a mesh larger than the
+     * byte budget still makes progress.
+     * @param upload Callable taking a const ChunkMesh &, performs the upload.
+     * @param clock Callable returning the current time in seconds.
+     * @return Number of meshes uploaded.
+     */
+    template <typename Upload, typename Clock>
+    size_t process(Upload upload, Clock clock)
+    {
+        double start = clock();
+        size_t bytes = 0;
+        size_t count = 0;
+
+        while (!mOrder.empty()) {
+            auto it = mPending.find(mOrder.front());
+            size_t size = it->second->byteSize();
+
+            if (count > 0) {
+                if (bytes + size > mBudget.maxBytes)
+                    break;
+                if (clock() - start >= mBudget.maxSeconds)
+                    break;
+            }
+
+            std::unique_ptr<ChunkMesh> mesh = std::move(it->second);
+            mPending.erase(it);
+            mOrder.pop_front();
+
+            upload(*mesh);
+            bytes += size;
+            count++;
+        }
+
+        return count;
+    }
+
+    /** Gets the number of meshes waiting for upload. */
+    size_t pendingCount() const
+    {
+        return mOrder.size();
+    }
+
+private:
+    /** Per-frame upload limits. */
+    UploadBudget mBudget;
+    /** Chunks with a pending mesh, in arrival order. */
+    std::deque<ChunkPosition> mOrder;
+    /** Latest pending mesh of each chunk. */
+    std::unordered_map<ChunkPosition, std::unique_ptr<ChunkMesh>, ChunkPositionHash> mPending;
+};
@@ -0,0 +1,230 @@
+/**
+ * @file World.h
+ * Fixed grid of chunks addressed by world voxel coordinates. Provides the
+ * cross-chunk voxel and light access used by light propagation, and takes
+ * the bordered snapshots handed to the mesher.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include "Chunk.h"
+#include "ChunkMesh.h"
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+/** Set of chunks, used to collect chunks needing a remesh. */
+typedef std::unordered_set<ChunkPosition, ChunkPositionHash> ChunkSet;
+
+/**
+ * @class World
+ * Box of width x height x depth chunks centred on the origin. Coordinates
+ * outside of the box read as empty, unlit space and ignore writes.
+ */
+class World
+{
+public:
+    /**
+     * Creates an empty world.
+     * @param width Number of chunks along x.
+     * @param height Number of chunks along y.
+     * @param depth Number of chunks along z.
+     */
+    World(int width, int height, int depth)
+        : mWidth(width), mHeight(height), mDepth(depth),
+          mMin({ -width / 2, -height / 2, -depth / 2 }), mSnapshotVersion(0)
+    {
+        for (int y = 0; y < height; y++) {
+            for (int z = 0; z < depth; z++) {
+                for (int x = 0; x < width; x++) {
+                    mChunks.push_back(Chunk({ mMin.x + x, mMin.y + y, mMin.z + z }));
+                }
+            }
+        }
+    }
+
+    /** Gets all chunks of the world. */
+    std::vector<Chunk> &chunks()
+    {
+        return mChunks;
+    }
+
+    /** Gets all chunks of the world. */
+    const std::vector<Chunk> &chunks() const
+    {
+        return mChunks;
+    }
+
+    /**
+     * Finds a chunk by position.
+     * @return The chunk, or null if it lies outside of the world.
+     */
+    Chunk *chunk(const ChunkPosition &p)
+    {
+        int x = p.x - mMin.x;
+        int y = p.y - mMin.y;
+        int z = p.z - mMin.z;
+        if (x < 0 || x >= mWidth || y < 0 || y >= mHeight || z < 0 || z >= mDepth)
+            return nullptr;
+        return &mChunks[x + mWidth * (z + mDepth * y)];
+    }
+
+    /**
+     * Finds a chunk by position.
+     * @return The chunk, or null if it lies outside of the world.
+     */
+    const Chunk *chunk(const ChunkPosition &p) const
+    {
+        return const_cast<World *>(this)->chunk(p);
+    }
+
+    /** Gets the lowest world y coordinate inside the world. */
+    int bottom() const
+    {
+        return mMin.y * CHUNK_SIZE;
+    }
+
+    /** Gets one past the highest world y coordinate inside the world. */
+    int top() const
+    {
+        return (mMin.y + mHeight) * CHUNK_SIZE;
+    }
+
+    /** Checks whether world voxel coordinates lie inside the world. */
+    bool contains(int x, int y, int z) const
+    {
+        return chunk(chunkOf(x, y, z)) != nullptr;
+    }
+
+    /** Gets a voxel by world coordinates. */
+    Voxel voxel(int x, int y, int z) const
+    {
+        const Chunk *c = chunk(chunkOf(x, y, z));
+        return c ? c->get(local(x), local(y), local(z)) : VOXEL_AIR;
+    }
+
+    /** Sets a voxel by world coordinates. Does not update light. */
+    void setVoxel(int x, int y, int z, Voxel voxel)
+    {
+        Chunk *c = chunk(chunkOf(x, y, z));
+        if (c)
+            c->set(local(x), local(y), local(z), voxel);
+    }
+
+    /** Gets a light level by world coordinates. */
+    uint8_t light(LightChannel channel, int x, int y, int z) const
+    {
+        const Chunk *c = chunk(chunkOf(x, y, z));
+        return c ? c->light(channel, local(x), local(y), local(z)) : 0;
+    }
+
+    /** Sets a light level by world coordinates. */
+    void setLight(LightChannel channel, int x, int y, int z, uint8_t level)
+    {
+        Chunk *c = chunk(chunkOf(x, y, z));
+        if (c)
+            c->setLight(channel, local(x), local(y), local(z), level);
+    }
+
+    /**
+     * Adds every chunk whose mesh can depend on a voxel to a set. Besides the
+     * voxel's own chunk, that includes neighbours the voxel borders on.
+     * @param x World x coordinate.
+     * @param y World y coordinate.
+     * @param z World z coordinate.
+     * @param chunks Set receiving the affected chunk positions.
+     */
+    void collectAffected(int x, int y, int z, ChunkSet &chunks) const
+    {
+        ChunkPosition p = chunkOf(x, y, z);
+        int lx = local(x), ly = local(y), lz = local(z);
+        for (int dy = ly == 0 ? -1 : 0; dy <= (ly == CHUNK_SIZE - 1 ? 1 : 0); dy++) {
+            for (int dz = lz == 0 ? -1 : 0; dz <= (lz == CHUNK_SIZE - 1 ? 1 : 0); dz++) {
+                for (int dx = lx == 0 ? -1 : 0; dx <= (lx == CHUNK_SIZE - 1 ? 1 : 0); dx++) {
+                    ChunkPosition n = { p.x + dx, p.y + dy, p.z + dz };
+                    if (chunk(n))
+                        chunks.insert(n);
+                }
+            }
+        }
+    }
+
+    /**
+     * Copies a chunk and a one voxel border around it for meshing. Space
+     * outside of the world reads as empty and open to the sky.
+     * @param position Chunk to copy. Must lie inside the world.
+     * @return Snapshot with a version newer than all earlier snapshots.
+     */
+    ChunkSnapshot snapshot(const ChunkPosition &position)
+    {
+        ChunkSnapshot s;
+        s.position = position;
+        s.version = ++mSnapshotVersion;
+
+        int ox = position.x * CHUNK_SIZE;
+        int oy = position.y * CHUNK_SIZE;
+        int oz = position.z * CHUNK_SIZE;
+        const Chunk &center = *chunk(position);
+
+        for (int y = -1; y <= CHUNK_SIZE; y++) {
+            for (int z = -1; z <= CHUNK_SIZE; z++) {
+                for (int x = -1; x <= CHUNK_SIZE; x++) {
+                    int i = ChunkSnapshot::index(x, y, z);
+                    Voxel v;
+                    uint8_t sky, block;
+                    if (Chunk::contains(x, y, z)) {
+                        v = center.get(x, y, z);
+                        sky = center.light(LIGHT_SKY, x, y, z);
+                        block = center.light(LIGHT_BLOCK, x, y, z);
+                    }
+                    else if (contains(ox + x, oy + y, oz + z)) {
+                        v = voxel(ox + x, oy + y, oz + z);
+                        sky = light(LIGHT_SKY, ox + x, oy + y, oz + z);
+                        block = light(LIGHT_BLOCK, ox + x, oy + y, oz + z);
+                    }
+                    else {
+                        v = VOXEL_AIR;
+                        sky = MAX_LIGHT;
+                        block = 0;
+                    }
+                    s.voxels[i] = v;
+                    s.light[i] = (uint8_t)((sky << 4) | block);
+                }
+            }
+        }
+
+        return s;
+    }
+
+    /** Gets the chunk containing world voxel coordinates. */
+    static ChunkPosition chunkOf(int x, int y, int z)
+    {
+        return { floorDiv(x), floorDiv(y), floorDiv(z) };
+    }
+
+    /** Converts a world coordinate to a coordinate within its chunk. */
+    static int local(int v)
+    {
+        return v - floorDiv(v) * CHUNK_SIZE;
+    }
+
+private:
+    /** Number of chunks along each axis. */
+    int mWidth;
+    int mHeight;
+    int mDepth;
+    /** Position of the chunk with the lowest coordinates. */
+    ChunkPosition mMin;
+    /** Version given to the most recent snapshot. */
+    uint32_t mSnapshotVersion;
+    /** Chunk storage, x-major within rows, then z, then y. */
+    std::vector<Chunk> mChunks;
+
+    /** Divides by CHUNK_SIZE, rounding towards negative infinity. */
+    static int floorDiv(int v)
+    {
+        return v >= 0 ? v / CHUNK_SIZE : (v - CHUNK_SIZE + 1) / CHUNK_SIZE;
+    }
+};
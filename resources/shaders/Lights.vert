@@ -0,0 +1,69 @@
+/**
+ * @file Lights.vert
+ * Vertex shader preamble which defines structs, uniforms, and functions for
+ * turning baked voxel lighting into a color. Light levels and ambient
+ * occlusion are computed on the CPU during meshing, so evaluating them here
+ * once per vertex leaves the fragment shader with nothing to do but
+ * interpolate.
+ */
+
+#version 410
+
+/** Material struct stores basic light interaction propertes. */
+struct Material
+{
+    vec3 ambient;
+    vec3 diffuse;
+};
+
+/**
+ * Directional Light struct stores light direction and properties. Only
+ * surfaces reached by sky light receive it.
+ */
+struct DirectionalLight
+{
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+};
+
+/** Defines how the surface reacts to light. */
+uniform Material material;
+/** Directional light source. Only one allowed per scene. */
+uniform DirectionalLight directionalLight;
+/** Color of block light at full strength. */
+uniform vec3 blockLightColor;
+
+/**
+ * Maps a normalized light level to brightness. Each level below the maximum
+ * dims the light by a constant factor, as light falls off with distance.
+ * @param level Light level in [0, 1].
+ * @return Brightness in (0, 1].
+ */
+float lightLevelBrightness(float level)
+{
+    return pow(0.8, 15.0 * (1.0 - level));
+}
+
+/**
+ * Calculates the vertex color from baked lighting.
+ * @param light Sky light, block light, and ambient occlusion, each in [0, 1].
+ * @param vNorm Normal vector of this vertex in world space, pre-normalized.
+ * @return Lit color of the surface at this vertex.
+ */
+vec3 calculateBakedLight(vec4 light, vec3 vNorm)
+{
+    // Sunlight is scaled by how much sky the vertex can see.
+    vec3 lightDir = normalize(-directionalLight.direction);
+    vec3 sun = directionalLight.ambient +
+               max(dot(vNorm, lightDir), 0.0) * directionalLight.diffuse;
+    vec3 sky = sun * lightLevelBrightness(light.x);
+
+    // Block light has no direction, it only fades with distance.
+    vec3 block = blockLightColor * lightLevelBrightness(light.y);
+
+    // Darken occluded corners, but never fully to black.
+    float occlusion = mix(0.35, 1.0, light.z);
+
+    return (material.ambient + material.diffuse * (sky + block)) * occlusion;
+}
@@ -1,10 +1,12 @@
 /**
  * @file VertexColor.vert
- * Trivial vertex shader uses projection matrices and vertex data to generate 
- * position and normal data for use in the fragment shader.
+ * Vertex shader uses projection matrices and vertex data to generate the
+ * clip space position, and turns the baked per-vertex lighting into a color
+ * for the fragment shader to interpolate.
  */
 
-#version 410
+ // Used by a live compilation plugin I use in MSVS.
+//! #include "Lights.vert"
 
 /** Local to World transform. */
 uniform mat4 model;
@@ -13,26 +15,31 @@ uniform mat4 view;
 /** View to Clip transform. */
 uniform mat4 projection;
 
-/** Cube position in world space. */
-in vec3 cubePosition;
-/** Vertex position in local space. */
+/** World space origin of every chunk, indexed by chunk number. */
+uniform samplerBuffer chunkOrigins;
+
+/** Vertex position in chunk space. */
 in vec3 vertexPosition;
 /** Vertex normal in local space. */
 in vec3 vertexNormal;
+/** Index of the chunk this vertex belongs to. */
+in uint vertexChunk;
+/** Baked sky light, block light, and ambient occlusion. */
+in vec4 vertexLight;
 
-/** Vertex position in world space. */
-out vec3 vert_pos;
-/** Vertex normal in world space. */
-out vec3 vert_normal;
+/** Lit vertex color. */
+out vec3 vert_color;
 
 /**
  * Applies world transform in order to get world position and normal of vertex
- * data. Transforms position into clip space to set GL position.
+ * data. Transforms position into clip space to set GL position, and lights
+ * the vertex.
  */
 void main() 
 {
-    vert_pos = vec3(model * vec4(vertexPosition + vec3(gl_InstanceID % 16, (gl_InstanceID / 16) % 16, gl_InstanceID / 256), 1.0));
-    vert_normal = vec3(model * vec4(vertexNormal, 1.0));
+    vec3 position = vec3(model * vec4(vertexPosition + texelFetch(chunkOrigins, int(vertexChunk)).xyz, 1.0));
+    vec3 normal = normalize(mat3(model) * vertexNormal);
 
-    gl_Position = projection * view * vec4(vert_pos, 1.0);
-}
\ No newline at end of file
+    vert_color = calculateBakedLight(vertexLight, normal);
+    gl_Position = projection * view * vec4(position, 1.0);
+}
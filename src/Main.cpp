@@ -5,10 +5,11 @@
  * LICENSE.txt file. This application is distributed under a similar BSD style
  * license. More information is available in the top level LICENSE.txt file.
  *
- * Draws an icosahedron inside a NanoGUI canvas. Has buttons to randomize
- * rotation and background color of the canvas.
+ * Draws a grid of voxel chunks inside a NanoGUI canvas. Chunks are lit by
+ * flood fill, meshed with baked per-vertex lighting on worker threads, and
+ * uploaded on the GL thread within a per-frame budget. Has buttons to
+ * randomize the background color and to scramble voxels.
  * @author Matthew McLaurin
- * @TODO Create a struct to house vertex information.
  * @TODO SceneObject class which has modifiable world transform.
  * @TODO Custom free rotating perspective camera.
  */
@@ -25,7 +26,15 @@
 #include <nanogui/colorwheel.h>
 #include <nanogui/glcanvas.h>
 
+#include "Chunk.h"
+#include "ChunkMesh.h"
+#include "LightPropagator.h"
+#include "MeshUploader.h"
+#include "MeshWorker.h"
 #include "Shader.h"
+#include "Terrain.h"
+#include "UploadScheduler.h"
+#include "World.h"
 
 // For logging.
 #include <iostream>
@@ -57,89 +66,37 @@ public:
      * @TODO Move shaders into separate files. Look into serializing them.
      * @TODO Refactor shader inputs as a uniform buffer object.
      */
-    Canvas(Widget *parent) : nanogui::GLCanvas(parent)
+    Canvas(Widget *parent) : nanogui::GLCanvas(parent), world(WORLD_WIDTH, WORLD_HEIGHT, WORLD_DEPTH)
     {
-        std::string vertexPath[1] = { "../resources/shaders/VertexColor.vert" };
-        std::string fragmentPath[2] = { "../resources/shaders/Lights.frag", "../resources/shaders/VertexColor.frag" };
-        // Read shaders from file. Fragment shader is divided into two files.
-        if (!shader.initFromFiles("VertexColor", vertexPath, fragmentPath, nullptr, 1, 2, 0)) {
+        std::string vertexPath[2] = { "../resources/shaders/Lights.vert", "../resources/shaders/VertexColor.vert" };
+        std::string fragmentPath[1] = { "../resources/shaders/VertexColor.frag" };
+        // Read shaders from file. Vertex shader is divided into two files.
+        if (!shader.initFromFiles("VertexColor", vertexPath, fragmentPath, nullptr, 2, 1, 0)) {
             std::cerr << "Failed to initialize shaders." << std::endl;
         }
 
         arcball.setSize(size());
-        // Index buffer. Counter-clockwise winding order.
-        nanogui::MatrixXu indices(3, 12);
-        indices.col(0) << 0, 2, 1;
-        indices.col(1) << 3, 1, 2;
-        indices.col(2) << 0, 4, 2;
-        indices.col(3) << 6, 2, 4;
-        indices.col(4) << 3, 2, 6;
-        indices.col(5) << 7, 3, 6;
-        indices.col(6) << 1, 3, 7;
-        indices.col(7) << 5, 1, 7;
-        indices.col(8) << 0, 1, 5;
-        indices.col(9) << 4, 0, 5;
-        indices.col(10) << 4, 5, 6;
-        indices.col(11) << 7, 6, 5;
-
-        // Vertex locations of a cube.
-        nanogui::MatrixXf positions(3, 8);
-        positions.col(0) << -0.5f,  0.5f,  0.5f;
-        positions.col(1) <<  0.5f,  0.5f,  0.5f;
-        positions.col(2) << -0.5f, -0.5f,  0.5f;
-        positions.col(3) <<  0.5f, -0.5f,  0.5f;
-        positions.col(4) << -0.5f,  0.5f, -0.5f;
-        positions.col(5) <<  0.5f,  0.5f, -0.5f;
-        positions.col(6) << -0.5f, -0.5f, -0.5f;
-        positions.col(7) <<  0.5f, -0.5f, -0.5f;
-
-        // Transforms of the instanced cubes.
-        nanogui::MatrixXf transforms(3, 8);
-        transforms.col(0) << 0.0f, 0.0f, 0.0f;
-        transforms.col(1) << 0.0f, 0.0f, 1.0f;
-        transforms.col(2) << 0.0f, 1.0f, 0.0f;
-        transforms.col(3) << 0.0f, 1.0f, 1.0f;
-        transforms.col(4) << 1.0f, 0.0f, 0.0f;
-        transforms.col(5) << 1.0f, 0.0f, 1.0f;
-        transforms.col(6) << 1.0f, 1.0f, 0.0f;
-        transforms.col(7) << 1.0f, 1.0f, 1.0f;
-
-
-
-
-        nanogui::MatrixXf normals(3, 8);
-        for (int i = 0; i < positions.cols(); i++) {
-            normals.col(i) = positions.col(i).normalized();
+
+        // Fill the world with terrain and light it.
+        generateTerrain(world);
+        lightPropagator.propagateAll(world);
+
+        // Mesh every chunk in the background. Results arrive through meshQueue.
+        meshWorker.reset(new MeshWorker(meshQueue));
+        for (const Chunk &chunk : world.chunks()) {
+            meshWorker->submit(world.snapshot(chunk.position()));
         }
 
-        // Use the shader program, sending vertex and uniform data.
+        // Use the shader program, sending uniform data.
         shader.bind();
-        shader.uploadIndices(indices);
-        shader.uploadAttrib("vertexPosition", positions);
-        shader.uploadAttrib("vertexNormal", normals);
-      //  shader.uploadAttrib("cubePosition", transforms);
-       // glVertexAttribDivisor(shader.attrib("cubePosition", true), 1);
-
-        shader.setUniform("material.ambient", nanogui::Vector3f(1.0f, 0.5f, 0.31f));
+        shader.setUniform("material.ambient", nanogui::Vector3f(0.02f, 0.01f, 0.006f));
         shader.setUniform("material.diffuse", nanogui::Vector3f(1.0f, 0.5f, 0.31f));
-        shader.setUniform("material.specular", nanogui::Vector3f(0.5f, 0.5f, 0.5f));
-        shader.setUniform("material.shininess", 32.0f);
-
-        shader.setUniform("viewPosition", cameraPosition);
-        shader.setUniform("numPointLights", 0);
-
-        shader.setUniform("pointLights[0].position", nanogui::Vector3f(2.0f, 0.0f, 0.0f));
-        shader.setUniform("pointLights[0].ambient", nanogui::Vector3f(0.2f, 0.2f, 0.2f));
-        shader.setUniform("pointLights[0].diffuse", nanogui::Vector3f(0.5f, 0.5, 0.5f));
-        shader.setUniform("pointLights[0].specular", nanogui::Vector3f(1.0f, 1.0f, 1.0f));
-        shader.setUniform("pointLights[0].constant", 1.0f);
-        shader.setUniform("pointLights[0].linear", 0.14f);
-        shader.setUniform("pointLights[0].quadratic", 0.07f);
 
         shader.setUniform("directionalLight.direction", nanogui::Vector3f(1.0f, -1.0f, 1.0f));
-        shader.setUniform("directionalLight.ambient", nanogui::Vector3f(0.2f, 0.2f, 0.2f));
-        shader.setUniform("directionalLight.diffuse", nanogui::Vector3f(0.5f, 0.5f, 0.5f));
-        shader.setUniform("directionalLight.specular", nanogui::Vector3f(1.0f, 1.0f, 1.0f));
+        shader.setUniform("directionalLight.ambient", nanogui::Vector3f(0.4f, 0.4f, 0.45f));
+        shader.setUniform("directionalLight.diffuse", nanogui::Vector3f(0.6f, 0.6f, 0.55f));
+
+        shader.setUniform("blockLightColor", nanogui::Vector3f(1.0f, 0.8f, 0.5f));
 
         // Initialize transforms.
         projection = nanogui::frustum(-0.1f, 0.1f, -0.1f, 0.1f, 0.1f, 1000.0f);
@@ -151,11 +108,12 @@ public:
     }
 
     /**
-     * Destructor frees shaders. NanoGUI will automatically free GLFW resources
-     * if the container is destroyed.
+     * Destructor frees shaders and mesh buffers. NanoGUI will automatically
+     * free GLFW resources if the container is destroyed.
      */
     ~Canvas()
     {
+        meshUploader.free();
         shader.free();
     }
 
@@ -181,19 +139,33 @@ public:
 
         view = nanogui::lookAt(cameraPosition, cameraPosition + cameraDirection, nanogui::Vector3f(0.0f, 1.0f, 0.0f));
         
-        // Use the Canvas' shader program. Includes vertex data.
+        // Collect finished meshes from the workers. Never blocks.
+        std::unique_ptr<ChunkMesh> mesh;
+        while (meshQueue.tryPop(mesh)) {
+            uploadScheduler.enqueue(std::move(mesh));
+        }
+
+        // Swap in last frame's uploads, then upload what fits this frame.
+        meshUploader.promote();
+        uploadScheduler.process(
+            [this](const ChunkMesh &m) { meshUploader.upload(m); },
+            []() { return glfwGetTime(); });
+
+        // Use the Canvas' shader program.
         shader.bind();
 
         // Send transform data to the shader.
-        shader.setUniform("viewPosition", cameraPosition);
         shader.setUniform("model", rot);
         shader.setUniform("view", view);
         shader.setUniform("projection", projection);
 
-        // Draw triangles, assuming the shader has vertex and index data.
+        shader.setUniform("chunkOrigins", 0);
+
+        // Draw every resident chunk in a single multi-draw call.
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
-        shader.drawElementsInstanced(GL_TRIANGLES, 0, 12, 4096);
+        meshUploader.draw(shader.attrib("vertexPosition"), shader.attrib("vertexNormal"),
+            shader.attrib("vertexChunk"), shader.attrib("vertexLight"), 0);
         glDisable(GL_DEPTH_TEST);
         glDisable(GL_CULL_FACE);
 
@@ -236,6 +208,43 @@ public:
         return false;
     }
 
+    /**
+     * Toggles a number of random voxels, some of which become lamps, then
+     * updates light and remeshes every chunk whose lighting changed.
+     * Remeshing happens in the background, so this returns immediately.
+     * @param count Number of voxels to toggle.
+     */
+    void scrambleVoxels(int count)
+    {
+        ChunkSet affected;
+        for (int i = 0; i < count; i++) {
+            const Chunk &chunk = world.chunks()[rand() % world.chunks().size()];
+            int x = chunk.position().x * CHUNK_SIZE + rand() % CHUNK_SIZE;
+            int y = chunk.position().y * CHUNK_SIZE + rand() % CHUNK_SIZE;
+            int z = chunk.position().z * CHUNK_SIZE + rand() % CHUNK_SIZE;
+
+            Voxel previous = world.voxel(x, y, z);
+            Voxel voxel = VOXEL_AIR;
+            if (previous == VOXEL_AIR)
+                voxel = rand() % 16 == 0 ? VOXEL_LAMP : VOXEL_SOLID;
+            world.setVoxel(x, y, z, voxel);
+            lightPropagator.voxelChanged(world, x, y, z, previous, affected);
+        }
+
+        for (const ChunkPosition &p : affected) {
+            meshWorker->submit(world.snapshot(p));
+        }
+    }
+
+    /**
+     * Sets how much mesh data may be uploaded to the GPU per frame.
+     * @param budget Byte and time limits per frame.
+     */
+    void setUploadBudget(const UploadBudget &budget)
+    {
+        uploadScheduler.setBudget(budget);
+    }
+
     /**
      * Gets the frame render time.
      */
@@ -244,8 +253,25 @@ public:
     }
 
 private:
+    /** Chunk grid dimensions, in chunks. */
+    static const int WORLD_WIDTH = 4;
+    static const int WORLD_HEIGHT = 2;
+    static const int WORLD_DEPTH = 4;
+
     /** Canvas shader object. Contains both the shader program and VAOs.*/
     Shader shader;  
+    /** Voxel and light data of every chunk. */
+    World world;
+    /** Keeps the light stored in the world up to date. */
+    LightPropagator lightPropagator;
+    /** Finished meshes handed over from the mesh worker threads. */
+    ChunkMeshQueue meshQueue;
+    /** Background meshing threads. Declared after the queue they feed. */
+    std::unique_ptr<MeshWorker> meshWorker;
+    /** Meshes waiting for a frame with upload budget left. */
+    UploadScheduler uploadScheduler;
+    /** Shared GPU buffers holding the chunk meshes. */
+    MeshUploader meshUploader;
     /** Transform matrix for the rendered shape. */
     nanogui::Matrix4f mvp;
     /** Perspective projection matrix. */
@@ -257,7 +283,7 @@ private:
     /** Temporary arcball rotation matrix. */
     nanogui::Matrix4f rot = nanogui::Matrix4f::Identity();
     /** Camera position. */
-    nanogui::Vector3f cameraPosition = nanogui::Vector3f(0.0f, 0.0f, -16.0f);
+    nanogui::Vector3f cameraPosition = nanogui::Vector3f(0.0f, 0.0f, -80.0f);
     /** Camera rotation. */
     nanogui::Vector3f cameraDirection = nanogui::Vector3f(0.0f, 0.0f, 1.0f);
     /** Per-frame movement vector. */
@@ -308,8 +334,9 @@ public:
         nanogui::Button *b0 = new nanogui::Button(tools, "Random Color");
         b0->setCallback([this]() { mCanvas->setBackgroundColor(nanogui::Vector4i(rand() % 256, rand() % 256, rand() % 256, 255)); });
 
-        // Add rotate button, which randomizes current rotation on press.
-        nanogui::Button *b1 = new nanogui::Button(tools, "Do Nothing");
+        // Add scramble button, which toggles random voxels and remeshes.
+        nanogui::Button *b1 = new nanogui::Button(tools, "Scramble Voxels");
+        b1->setCallback([this]() { mCanvas->scrambleVoxels(256); });
         window->center();
 
         // Lay out the UI elements.
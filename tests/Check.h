@@ -0,0 +1,38 @@
+/**
+ * @file Check.h
+ * Minimal assertion helpers shared by the test executables. Checks report
+ * failures and keep running, and are not compiled out in release builds.
+ * @author Matthew McLaurin
+ */
+
+#pragma once
+
+#include <iostream>
+
+/** Number of failed checks in this test executable. */
+static int checkFailures = 0;
+
+/** Records a failure if the condition does not hold. */
+#define CHECK(condition)                                                     \
+    do {                                                                     \
+        if (!(condition)) {                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__                         \
+                      << ": check failed: " #condition << std::endl;         \
+            checkFailures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+/**
+ * Prints a summary and converts the failure count into an exit code.
+ * @param name Name of the test executable.
+ * @return Zero if every check passed, one otherwise.
+ */
+inline int checkResult(const char *name)
+{
+    if (checkFailures == 0) {
+        std::cout << name << ": all checks passed." << std::endl;
+        return 0;
+    }
+    std::cerr << name << ": " << checkFailures << " checks failed." << std::endl;
+    return 1;
+}
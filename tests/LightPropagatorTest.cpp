@@ -0,0 +1,116 @@
+/**
+ * @file LightPropagatorTest.cpp
+ * Checks that incremental light updates agree with recomputing the light of
+ * the whole world from scratch.
+ * @author Matthew McLaurin
+ */
+
+#include "Check.h"
+#include "LightPropagator.h"
+#include "World.h"
+
+#include <random>
+
+/**
+ * Counts voxels whose light differs from a full recomputation.
+ * @param world World updated incrementally.
+ * @return Number of voxels with a different sky or block light level.
+ */
+int countMismatches(const World &world)
+{
+    World expected = world;
+    LightPropagator propagator;
+    propagator.propagateAll(expected);
+
+    int mismatches = 0;
+    for (const Chunk &chunk : world.chunks()) {
+        const Chunk &other = *expected.chunk(chunk.position());
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int z = 0; z < CHUNK_SIZE; z++) {
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    if (chunk.light(LIGHT_SKY, x, y, z) != other.light(LIGHT_SKY, x, y, z) ||
+                        chunk.light(LIGHT_BLOCK, x, y, z) != other.light(LIGHT_BLOCK, x, y, z))
+                        mismatches++;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+/** Changes one voxel and updates light incrementally. */
+void edit(World &world, LightPropagator &propagator, int x, int y, int z, Voxel voxel)
+{
+    Voxel previous = world.voxel(x, y, z);
+    world.setVoxel(x, y, z, voxel);
+    ChunkSet affected;
+    propagator.voxelChanged(world, x, y, z, previous, affected);
+}
+
+/** Fills the lower half of a world with solid ground. */
+void fillGround(World &world)
+{
+    for (int y = world.bottom(); y < 0; y++) {
+        for (int z = -CHUNK_SIZE; z < CHUNK_SIZE; z++) {
+            for (int x = -CHUNK_SIZE; x < CHUNK_SIZE; x++)
+                world.setVoxel(x, y, z, VOXEL_SOLID);
+        }
+    }
+}
+
+/**
+ * Placing and removing a voxel in the top layer restores full sky light to
+ * the column below it.
+ */
+void testTopLayerEdit()
+{
+    World world(2, 2, 2);
+    LightPropagator propagator;
+    propagator.propagateAll(world);
+    int y = world.top() - 1;
+
+    edit(world, propagator, 3, y, 3, VOXEL_SOLID);
+    CHECK(countMismatches(world) == 0);
+    CHECK(world.light(LIGHT_SKY, 3, y - 1, 3) == MAX_LIGHT - 1);
+
+    edit(world, propagator, 3, y, 3, VOXEL_AIR);
+    CHECK(countMismatches(world) == 0);
+    CHECK(world.light(LIGHT_SKY, 3, y, 3) == MAX_LIGHT);
+    CHECK(world.light(LIGHT_SKY, 3, world.bottom(), 3) == MAX_LIGHT);
+}
+
+/**
+ * Random edits, including lamps and edits near the top of the world, keep
+ * the light identical to a full recomputation.
+ */
+void testRandomEdits()
+{
+    World world(2, 2, 2);
+    LightPropagator propagator;
+    fillGround(world);
+    propagator.propagateAll(world);
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> horizontal(-CHUNK_SIZE, CHUNK_SIZE - 1);
+    std::uniform_int_distribution<int> vertical(world.bottom(), world.top() - 1);
+    std::uniform_int_distribution<int> nearTop(world.top() - 3, world.top() - 1);
+    std::uniform_int_distribution<int> kind(0, 7);
+
+    int failedEdits = 0;
+    for (int i = 0; i < 120; i++) {
+        int y = i % 2 == 0 ? vertical(random) : nearTop(random);
+        int k = kind(random);
+        Voxel voxel = k == 0 ? VOXEL_LAMP : (k < 4 ? VOXEL_SOLID : VOXEL_AIR);
+        edit(world, propagator, horizontal(random), y, horizontal(random), voxel);
+        if (countMismatches(world) != 0)
+            failedEdits++;
+    }
+    CHECK(failedEdits == 0);
+}
+
+int main()
+{
+    testTopLayerEdit();
+    testRandomEdits();
+    return checkResult("LightPropagatorTest");
+}
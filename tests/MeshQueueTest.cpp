@@ -0,0 +1,115 @@
+/**
+ * @file MeshQueueTest.cpp
+ * Tests for the lock-free MPSC mesh queue.
+ * @author Matthew McLaurin
+ */
+
+#include "Check.h"
+#include "MeshQueue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/** Counts live instances, to detect leaks on queue destruction. */
+struct Counted
+{
+    static std::atomic<int> live;
+
+    Counted(int producer, int sequence) : producer(producer), sequence(sequence)
+    {
+        live++;
+    }
+
+    ~Counted()
+    {
+        live--;
+    }
+
+    int producer;
+    int sequence;
+};
+
+std::atomic<int> Counted::live(0);
+
+/**
+ * Pushes from several threads while the consumer pops. Every element must
+ * arrive exactly once, and each producer's elements must stay in order.
+ */
+void testConcurrentProducers()
+{
+    const int producers = 4;
+    const int perProducer = 20000;
+    MeshQueue<std::unique_ptr<Counted>> queue;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < perProducer; i++)
+                queue.push(std::unique_ptr<Counted>(new Counted(p, i)));
+        });
+    }
+
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    bool ordered = true;
+    std::unique_ptr<Counted> item;
+    while (received < producers * perProducer) {
+        if (!queue.tryPop(item))
+            continue;
+        if (item->sequence != next[item->producer])
+            ordered = false;
+        next[item->producer] = item->sequence + 1;
+        received++;
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    CHECK(ordered);
+    CHECK(!queue.tryPop(item));
+    for (int p = 0; p < producers; p++)
+        CHECK(next[p] == perProducer);
+}
+
+/** An empty queue pops nothing, and elements come out in push order. */
+void testSingleThreadOrder()
+{
+    MeshQueue<int> queue;
+    int value = -1;
+    CHECK(!queue.tryPop(value));
+
+    for (int i = 0; i < 10; i++)
+        queue.push(i);
+    for (int i = 0; i < 10; i++) {
+        CHECK(queue.tryPop(value));
+        CHECK(value == i);
+    }
+    CHECK(!queue.tryPop(value));
+}
+
+/** Destroying a queue frees any elements that were never popped. */
+void testDestroyWithQueuedItems()
+{
+    Counted::live = 0;
+    {
+        MeshQueue<std::unique_ptr<Counted>> queue;
+        for (int i = 0; i < 100; i++)
+            queue.push(std::unique_ptr<Counted>(new Counted(0, i)));
+
+        std::unique_ptr<Counted> item;
+        CHECK(queue.tryPop(item));
+        item.reset();
+        CHECK(Counted::live == 99);
+    }
+    CHECK(Counted::live == 0);
+}
+
+int main()
+{
+    testSingleThreadOrder();
+    testConcurrentProducers();
+    testDestroyWithQueuedItems();
+    return checkResult("MeshQueueTest");
+}
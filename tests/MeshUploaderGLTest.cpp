@@ -0,0 +1,376 @@
+/**
+ * @file MeshUploaderGLTest.cpp
+ * Tests for MeshUploader against a real GL 4.1 core context. Renders into an
+ * offscreen framebuffer through a surfaceless EGL display, so it runs under a
+ * software driver such as Mesa's llvmpipe without a window system. Exits with
+ * SKIP_CODE when no such context can be created.
+ * @author Matthew McLaurin
+ */
+
+#include "Check.h"
+#include "MeshUploader.h"
+#include "World.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/** Exit code telling CTest the test was skipped. */
+const int SKIP_CODE = 77;
+/** Edge length of the framebuffer, in pixels. One pixel per voxel. */
+const int VIEW_SIZE = 64;
+
+/** Draws chunks flat on the xy plane, one voxel per pixel. */
+const char *VERTEX_SOURCE =
+    "#version 410\n"
+    "uniform samplerBuffer chunkOrigins;\n"
+    "in vec3 vertexPosition;\n"
+    "in vec3 vertexNormal;\n"
+    "in uint vertexChunk;\n"
+    "in vec4 vertexLight;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    vec3 p = vertexPosition + texelFetch(chunkOrigins, int(vertexChunk)).xyz;\n"
+    "    gl_Position = vec4(p.xy / 32.0, 0.0, 1.0);\n"
+    "    color = vec4(abs(vertexNormal) * 0.5 + vertexLight.xyz * 0.5, 1.0);\n"
+    "}\n";
+
+const char *FRAGMENT_SOURCE =
+    "#version 410\n"
+    "in vec4 color;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = color;\n"
+    "}\n";
+
+/**
+ * Makes a surfaceless GL 4.1 core context current.
+ * @return False if the platform cannot provide one.
+ */
+bool createContext()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay)
+        return false;
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        return false;
+    if (!eglBindAPI(EGL_OPENGL_API))
+        return false;
+
+    const EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 1,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if (context == EGL_NO_CONTEXT)
+        return false;
+    return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE;
+}
+
+/** Compiles and links the test shader program. */
+GLuint createProgram()
+{
+    const char *sources[2] = { VERTEX_SOURCE, FRAGMENT_SOURCE };
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    GLuint program = glCreateProgram();
+    for (int i = 0; i < 2; i++) {
+        GLuint shader = glCreateShader(types[i]);
+        glShaderSource(shader, 1, &sources[i], nullptr);
+        glCompileShader(shader);
+        GLint compiled = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        CHECK(compiled == GL_TRUE);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    CHECK(linked == GL_TRUE);
+    return program;
+}
+
+/** Renders resident chunks offscreen and reads the pixels back. */
+class Renderer
+{
+public:
+    Renderer()
+    {
+        glGenFramebuffers(1, &mFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+        glGenRenderbuffers(1, &mColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, mColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, VIEW_SIZE, VIEW_SIZE);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColor);
+        CHECK(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+        glViewport(0, 0, VIEW_SIZE, VIEW_SIZE);
+
+        mProgram = createProgram();
+        glGenVertexArrays(1, &mVertexArray);
+        mPixels.resize(VIEW_SIZE * VIEW_SIZE);
+    }
+
+    /** Draws every resident chunk and reads back the framebuffer. */
+    void render(MeshUploader &uploader)
+    {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glUseProgram(mProgram);
+        glBindVertexArray(mVertexArray);
+        glUniform1i(glGetUniformLocation(mProgram, "chunkOrigins"), 0);
+        uploader.draw(glGetAttribLocation(mProgram, "vertexPosition"),
+            glGetAttribLocation(mProgram, "vertexNormal"),
+            glGetAttribLocation(mProgram, "vertexChunk"),
+            glGetAttribLocation(mProgram, "vertexLight"), 0);
+        glReadPixels(0, 0, VIEW_SIZE, VIEW_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, mPixels.data());
+    }
+
+    /** Checks whether the pixel covering world voxel (x, y) was drawn. */
+    bool lit(int x, int y) const
+    {
+        return mPixels[(y + VIEW_SIZE / 2) * VIEW_SIZE + x + VIEW_SIZE / 2] != 0;
+    }
+
+    /** Counts the pixels that were drawn. */
+    int litCount() const
+    {
+        int count = 0;
+        for (uint32_t pixel : mPixels)
+            count += pixel != 0;
+        return count;
+    }
+
+private:
+    GLuint mFramebuffer = 0;
+    GLuint mColor = 0;
+    GLuint mProgram = 0;
+    GLuint mVertexArray = 0;
+    std::vector<uint32_t> mPixels;
+};
+
+/** Waits for the GPU, then swaps in every finished upload. */
+void settle(MeshUploader &uploader)
+{
+    glFinish();
+    uploader.promote();
+}
+
+/**
+ * Builds a mesh of a chunk holding a single solid voxel.
+ * @param world World the chunk is taken from.
+ * @param p Chunk position.
+ * @param solid True for one solid voxel at local (2, 2, 2), false for none.
+ */
+std::unique_ptr<ChunkMesh> voxelMesh(World &world, const ChunkPosition &p, bool solid)
+{
+    world.setVoxel(p.x * CHUNK_SIZE + 2, p.y * CHUNK_SIZE + 2, p.z * CHUNK_SIZE + 2,
+        solid ? VOXEL_SOLID : VOXEL_AIR);
+    return std::unique_ptr<ChunkMesh>(new ChunkMesh(buildChunkMesh(world.snapshot(p))));
+}
+
+/**
+ * Builds a large mesh for a chunk far outside of the view, used to fill the
+ * shared buffers. A checkerboard has the most faces a chunk can have.
+ * @param x Chunk x coordinate, 10 or more to stay out of view.
+ * @param version Mesh version.
+ */
+ChunkMesh fillerMesh(int x, uint32_t version)
+{
+    ChunkSnapshot snapshot;
+    snapshot.position = { x, 0, 0 };
+    snapshot.version = version;
+    snapshot.light.fill(0);
+    for (int y = -1; y <= CHUNK_SIZE; y++) {
+        for (int z = -1; z <= CHUNK_SIZE; z++) {
+            for (int lx = -1; lx <= CHUNK_SIZE; lx++) {
+                bool inside = Chunk::contains(lx, y, z);
+                snapshot.voxels[ChunkSnapshot::index(lx, y, z)] =
+                    inside && ((lx + y + z) & 1) ? VOXEL_SOLID : VOXEL_AIR;
+            }
+        }
+    }
+    return buildChunkMesh(snapshot);
+}
+
+/** Builds an empty mesh, which clears a chunk. */
+ChunkMesh emptyMesh(const ChunkPosition &p, uint32_t version)
+{
+    ChunkMesh mesh;
+    mesh.position = p;
+    mesh.version = version;
+    return mesh;
+}
+
+/**
+ * An upload only becomes visible once promoted, the old mesh keeps drawing
+ * until then, and stale versions are ignored.
+ */
+void testDoubleBuffering(Renderer &renderer)
+{
+    World world(2, 1, 1);
+    MeshUploader uploader;
+    const ChunkPosition a = { 0, 0, 0 };
+
+    std::unique_ptr<ChunkMesh> first = voxelMesh(world, a, true);
+    uploader.upload(*first);
+    renderer.render(uploader);
+    CHECK(renderer.litCount() == 0);
+
+    settle(uploader);
+    renderer.render(uploader);
+    CHECK(renderer.lit(2, 2));
+    CHECK(renderer.litCount() == 1);
+
+    std::unique_ptr<ChunkMesh> cleared = voxelMesh(world, a, false);
+    uploader.upload(*cleared);
+    renderer.render(uploader);
+    CHECK(renderer.lit(2, 2));
+
+    settle(uploader);
+    renderer.render(uploader);
+    CHECK(renderer.litCount() == 0);
+
+    // The first mesh is older than the cleared one and must be dropped.
+    uploader.upload(*first);
+    settle(uploader);
+    renderer.render(uploader);
+    CHECK(renderer.litCount() == 0);
+
+    CHECK(glGetError() == GL_NO_ERROR);
+    uploader.free();
+}
+
+/**
+ * Chunks keep drawing correctly after their data has been moved by buffer
+ * compaction and growth.
+ */
+void testRelocation(Renderer &renderer)
+{
+    World world(2, 1, 1);
+    MeshUploader uploader;
+    const ChunkPosition a = { 0, 0, 0 };
+    const ChunkPosition b = { -1, 0, 0 };
+
+    // A small mesh at the start of the buffers leaves a hole once cleared
+    // that no filler fits in, so the chunks behind it move when the buffers
+    // are compacted.
+    ChunkMesh small = *voxelMesh(world, a, true);
+    small.position = { 10, 0, 0 };
+    uploader.upload(small);
+    uploader.upload(*voxelMesh(world, a, true));
+    uploader.upload(*voxelMesh(world, b, true));
+    settle(uploader);
+    uploader.upload(emptyMesh({ 10, 0, 0 }, 2));
+    settle(uploader);
+    renderer.render(uploader);
+    settle(uploader);
+    CHECK(renderer.lit(2, 2));
+    CHECK(renderer.lit(-14, 2));
+
+    size_t initialBytes = uploader.allocatedBytes();
+    for (int i = 0; i < 8; i++)
+        uploader.upload(fillerMesh(11 + i, 1));
+    settle(uploader);
+    CHECK(uploader.allocatedBytes() > initialBytes);
+
+    renderer.render(uploader);
+    CHECK(renderer.lit(2, 2));
+    CHECK(renderer.lit(-14, 2));
+    CHECK(renderer.litCount() == 2);
+
+    CHECK(glGetError() == GL_NO_ERROR);
+    uploader.free();
+}
+
+/**
+ * Fills a new uploader's vertex buffer to within one filler mesh of its
+ * capacity, then replaces one filler with an empty mesh and promotes it.
+ */
+void fillAndReplace(MeshUploader &uploader)
+{
+    for (int i = 0; i < 5; i++)
+        uploader.upload(fillerMesh(10 + i, 1));
+    settle(uploader);
+    uploader.upload(emptyMesh({ 10, 0, 0 }, 2));
+    settle(uploader);
+}
+
+/**
+ * The ranges of a replaced mesh are only reused after a draw following the
+ * replacement has finished on the GPU.
+ */
+void testRetirement(Renderer &renderer)
+{
+    // Without a draw the replaced ranges stay allocated, so the next upload
+    // has to grow the buffers.
+    MeshUploader waiting;
+    fillAndReplace(waiting);
+    size_t initialBytes = waiting.allocatedBytes();
+    waiting.upload(fillerMesh(15, 1));
+    CHECK(waiting.allocatedBytes() > initialBytes);
+    waiting.free();
+
+    // Once a later draw has completed, the next upload reuses them.
+    MeshUploader reclaimed;
+    fillAndReplace(reclaimed);
+    renderer.render(reclaimed);
+    settle(reclaimed);
+    initialBytes = reclaimed.allocatedBytes();
+    reclaimed.upload(fillerMesh(15, 1));
+    CHECK(reclaimed.allocatedBytes() == initialBytes);
+    reclaimed.free();
+
+    CHECK(glGetError() == GL_NO_ERROR);
+}
+
+/**
+ * Uploads, including ones that rebuild the buffers, leave the element
+ * buffer of the bound vertex array alone.
+ */
+void testVertexArrayUntouched()
+{
+    GLuint vertexArray = 0;
+    GLuint elements = 0;
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &elements);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elements);
+
+    MeshUploader uploader;
+    for (int i = 0; i < 8; i++)
+        uploader.upload(fillerMesh(10 + i, 1));
+    settle(uploader);
+
+    GLint bound = 0;
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &bound);
+    CHECK(bound == (GLint)elements);
+
+    uploader.free();
+    glBindVertexArray(0);
+    glDeleteBuffers(1, &elements);
+    glDeleteVertexArrays(1, &vertexArray);
+    CHECK(glGetError() == GL_NO_ERROR);
+}
+
+int main()
+{
+    if (!createContext()) {
+        std::cerr << "MeshUploaderGLTest: no GL 4.1 context available, skipping." << std::endl;
+        return SKIP_CODE;
+    }
+
+    Renderer renderer;
+    testDoubleBuffering(renderer);
+    testRelocation(renderer);
+    testRetirement(renderer);
+    testVertexArrayUntouched();
+    return checkResult("MeshUploaderGLTest");
+}
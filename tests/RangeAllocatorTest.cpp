@@ -0,0 +1,151 @@
+/**
+ * @file RangeAllocatorTest.cpp
+ * Tests for the best-fit range allocator used by the shared mesh buffers.
+ * @author Matthew McLaurin
+ */
+
+#include "Check.h"
+#include "RangeAllocator.h"
+
+#include <cmath>
+#include <vector>
+
+/** Allocates a range, recording a failure if it does not fit. */
+size_t mustAllocate(RangeAllocator &allocator, size_t size)
+{
+    size_t offset = 0;
+    CHECK(allocator.allocate(size, offset));
+    return offset;
+}
+
+/** Allocation picks the smallest free range that fits, not the first. */
+void testBestFit()
+{
+    RangeAllocator allocator(100);
+    size_t a = mustAllocate(allocator, 10);
+    mustAllocate(allocator, 5);
+    size_t c = mustAllocate(allocator, 4);
+    mustAllocate(allocator, 5);
+    // Free ranges are now [0, 10), [15, 19) and [24, 100).
+    allocator.release(a);
+    allocator.release(c);
+
+    CHECK(mustAllocate(allocator, 3) == 15);
+    CHECK(mustAllocate(allocator, 8) == 0);
+    CHECK(mustAllocate(allocator, 20) == 24);
+
+    size_t offset = 0;
+    CHECK(!allocator.allocate(57, offset));
+    CHECK(allocator.usedSize() == 41);
+    CHECK(allocator.allocationCount() == 5);
+}
+
+/** Releasing a range between two free ranges merges all three. */
+void testReleaseMergesBothSides()
+{
+    RangeAllocator allocator(30);
+    size_t a = mustAllocate(allocator, 10);
+    size_t b = mustAllocate(allocator, 10);
+    size_t c = mustAllocate(allocator, 10);
+    CHECK(allocator.freeSize() == 0);
+
+    allocator.release(a);
+    allocator.release(c);
+    CHECK(allocator.largestFreeRange() == 10);
+
+    allocator.release(b);
+    CHECK(allocator.largestFreeRange() == 30);
+    CHECK(allocator.allocationCount() == 0);
+    CHECK(mustAllocate(allocator, 30) == 0);
+
+    // Unknown offsets are ignored.
+    allocator.release(5);
+    CHECK(allocator.usedSize() == 30);
+}
+
+/**
+ * Compaction reports moves in ascending order that close every gap, and a
+ * move may overlap its own destination.
+ */
+void testCompact()
+{
+    RangeAllocator allocator(100);
+    size_t a = mustAllocate(allocator, 4);
+    size_t b = mustAllocate(allocator, 10);
+    size_t c = mustAllocate(allocator, 6);
+    mustAllocate(allocator, 5);
+    size_t e = mustAllocate(allocator, 3);
+    allocator.release(a);
+    allocator.release(c);
+    // Live ranges: [4, 14), [20, 25) and [25, 28).
+    CHECK(e == 25);
+
+    std::vector<RangeAllocator::Move> moves = allocator.compact();
+    CHECK(moves.size() == 3);
+    if (moves.size() == 3) {
+        CHECK(moves[0].from == b && moves[0].to == 0 && moves[0].size == 10);
+        CHECK(moves[1].from == 20 && moves[1].to == 10 && moves[1].size == 5);
+        CHECK(moves[2].from == 25 && moves[2].to == 15 && moves[2].size == 3);
+        // The first move's source and destination overlap.
+        CHECK(moves[0].to + moves[0].size > moves[0].from);
+    }
+
+    CHECK(allocator.usedSize() == 18);
+    CHECK(allocator.largestFreeRange() == 82);
+    CHECK(allocator.fragmentation() == 0.0f);
+    CHECK(allocator.compact().empty());
+
+    // Moved ranges are released by their new offsets.
+    allocator.release(10);
+    CHECK(allocator.usedSize() == 13);
+}
+
+/** Growing extends a free range at the end instead of adding a new one. */
+void testGrow()
+{
+    RangeAllocator allocator(20);
+    mustAllocate(allocator, 15);
+    allocator.grow(40);
+    CHECK(allocator.capacity() == 40);
+    CHECK(allocator.largestFreeRange() == 25);
+    CHECK(mustAllocate(allocator, 25) == 15);
+
+    // With the end in use, growth adds a separate range.
+    allocator.grow(50);
+    CHECK(allocator.largestFreeRange() == 10);
+    CHECK(mustAllocate(allocator, 10) == 40);
+
+    // Shrinking is ignored.
+    allocator.grow(10);
+    CHECK(allocator.capacity() == 50);
+}
+
+/** Fragmentation compares the largest free range with all free space. */
+void testFragmentation()
+{
+    RangeAllocator allocator(40);
+    CHECK(allocator.fragmentation() == 0.0f);
+
+    size_t a = mustAllocate(allocator, 10);
+    mustAllocate(allocator, 10);
+    size_t c = mustAllocate(allocator, 10);
+    mustAllocate(allocator, 10);
+    CHECK(allocator.fragmentation() == 0.0f);
+
+    allocator.release(a);
+    allocator.release(c);
+    CHECK(std::fabs(allocator.fragmentation() - 0.5f) < 1e-6f);
+
+    allocator.compact();
+    CHECK(allocator.fragmentation() == 0.0f);
+}
+
+int main()
+{
+    testBestFit();
+    testReleaseMergesBothSides();
+    testCompact();
+    testGrow();
+    testFragmentation();
+    return checkResult("RangeAllocatorTest");
+}
@@ -0,0 +1,135 @@
+/**
+ * @file UploadSchedulerTest.cpp
+ * Tests for the frame budgeted upload scheduler, using a fake clock.
+ * @author Matthew McLaurin
+ */
+
+#include "Check.h"
+#include "UploadScheduler.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Creates a mesh with a given upload size.
+ * @param x Chunk x coordinate, to tell chunks apart.
+ * @param version Version of the mesh.
+ * @param indices Number of indices, each four bytes.
+ */
+std::unique_ptr<ChunkMesh> makeMesh(int x, uint32_t version, size_t indices)
+{
+    std::unique_ptr<ChunkMesh> mesh(new ChunkMesh());
+    mesh->position = { x, 0, 0 };
+    mesh->version = version;
+    mesh->indices.resize(indices);
+    return mesh;
+}
+
+/** Records uploaded chunks and versions. */
+struct Recorder
+{
+    std::vector<int> chunks;
+    std::vector<uint32_t> versions;
+
+    void operator()(const ChunkMesh &mesh)
+    {
+        chunks.push_back(mesh.position.x);
+        versions.push_back(mesh.version);
+    }
+};
+
+/** Uploads stop once the next mesh would exceed the byte budget. */
+void testByteBudget()
+{
+    UploadScheduler scheduler;
+    UploadBudget budget;
+    budget.maxBytes = 1000;
+    budget.maxSeconds = 1.0;
+    scheduler.setBudget(budget);
+
+    // 400 bytes each: two fit in 1000 bytes, the third does not.
+    for (int i = 0; i < 5; i++)
+        scheduler.enqueue(makeMesh(i, 0, 100));
+
+    Recorder recorder;
+    double now = 0.0;
+    auto clock = [&now]() { return now; };
+    CHECK(scheduler.process(std::ref(recorder), clock) == 2);
+    CHECK(scheduler.pendingCount() == 3);
+    CHECK(scheduler.process(std::ref(recorder), clock) == 2);
+    CHECK(scheduler.process(std::ref(recorder), clock) == 1);
+    CHECK(scheduler.pendingCount() == 0);
+    CHECK((recorder.chunks == std::vector<int>{ 0, 1, 2, 3, 4 }));
+}
+
+/** Uploads stop once the time budget has elapsed. */
+void testTimeBudget()
+{
+    UploadScheduler scheduler;
+    UploadBudget budget;
+    budget.maxBytes = 1 << 30;
+    budget.maxSeconds = 0.002;
+    scheduler.setBudget(budget);
+
+    for (int i = 0; i < 10; i++)
+        scheduler.enqueue(makeMesh(i, 0, 1));
+
+    // Each upload takes one millisecond of fake time.
+    double now = 0.0;
+    auto upload = [&now](const ChunkMesh &) { now += 0.001; };
+    auto clock = [&now]() { return now; };
+    CHECK(scheduler.process(upload, clock) == 2);
+    CHECK(scheduler.pendingCount() == 8);
+}
+
+/** The first mesh of a frame goes through even if it exceeds the budget. */
+void testFirstMeshAlwaysUploads()
+{
+    UploadScheduler scheduler;
+    UploadBudget budget;
+    budget.maxBytes = 16;
+    budget.maxSeconds = 0.0;
+    scheduler.setBudget(budget);
+
+    scheduler.enqueue(makeMesh(0, 0, 1000));
+    scheduler.enqueue(makeMesh(1, 0, 1000));
+
+    Recorder recorder;
+    auto clock = []() { return 5.0; };
+    CHECK(scheduler.process(std::ref(recorder), clock) == 1);
+    CHECK(scheduler.process(std::ref(recorder), clock) == 1);
+    CHECK(scheduler.process(std::ref(recorder), clock) == 0);
+    CHECK((recorder.chunks == std::vector<int>{ 0, 1 }));
+}
+
+/**
+ * A newer mesh replaces a pending one in place, and an older mesh never
+ * replaces a newer one.
+ */
+void testNewerVersionReplacesInPlace()
+{
+    UploadScheduler scheduler;
+    scheduler.enqueue(makeMesh(0, 1, 1));
+    scheduler.enqueue(makeMesh(1, 1, 1));
+    scheduler.enqueue(makeMesh(2, 1, 1));
+    scheduler.enqueue(makeMesh(0, 3, 1));
+    scheduler.enqueue(makeMesh(0, 2, 1));
+    scheduler.enqueue(std::unique_ptr<ChunkMesh>());
+    CHECK(scheduler.pendingCount() == 3);
+
+    Recorder recorder;
+    auto clock = []() { return 0.0; };
+    scheduler.process(std::ref(recorder), clock);
+    CHECK((recorder.chunks == std::vector<int>{ 0, 1, 2 }));
+    CHECK((recorder.versions == std::vector<uint32_t>{ 3, 1, 1 }));
+}
+
+int main()
+{
+    testByteBudget();
+    testTimeBudget();
+    testFirstMeshAlwaysUploads();
+    testNewerVersionReplacesInPlace();
+    return checkResult("UploadSchedulerTest");
+}
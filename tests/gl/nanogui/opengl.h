@@ -0,0 +1,10 @@
+/**
+ * @file opengl.h
+ * Stand-in for NanoGUI's GL header, so that GL-side tests can build against
+ * the system GL headers without NanoGUI.
+ */
+
+#pragma once
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glcorearb.h>